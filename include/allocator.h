@@ -1,5 +1,16 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 
 namespace yapvm::memory {
 
@@ -14,4 +25,238 @@ public:
     virtual void deallocate(void *data) = 0;
 };
 
-}
\ No newline at end of file
+
+// chunks are aligned to their size, so chunk of any object is found by address mask
+constexpr size_t CHUNK_SIZE = 256 * 1024;
+constexpr size_t ALLOCATION_ALIGN = 16;
+
+static_assert((CHUNK_SIZE & (CHUNK_SIZE - 1)) == 0);
+
+
+class Heap;
+
+
+constexpr size_t CHUNK_GRANULES = CHUNK_SIZE / ALLOCATION_ALIGN;
+constexpr size_t CHUNK_BITMAP_WORDS = CHUNK_GRANULES / 64;
+
+
+// header in the beginning of every chunk
+struct Chunk {
+    Heap *heap_;
+    std::atomic_int64_t pending_; // objects not freed yet, biased while chunk is owned by TLAB
+    Allocator *space_ = nullptr; // set if objects of chunk are freed through its allocator, see release
+    std::atomic_uint64_t marks_[CHUNK_BITMAP_WORDS]{}; // gc mark bit per granule, set at object start
+
+    Chunk(Heap *heap);
+
+    char *begin();
+    char *end();
+
+    static size_t granule(const void *data);
+
+    bool is_marked(const void *data) const;
+    void set_marked(const void *data, bool marked);
+    bool try_mark(const void *data); // true if it was not marked before, safe for concurrent markers
+
+    static Chunk *of(const void *data);
+};
+
+
+// thrown when allocation would take heap over its max size, interpreters report it and stop vm
+class OutOfMemory : public std::runtime_error {
+public:
+    explicit OutOfMemory(size_t max_size);
+};
+
+
+// gc owned source of chunks, every byte of objects and payloads is committed here and checked against max size (-Xmx):
+// chunks of objects, slab pages and big payloads out of slabs
+// chunks reserved by initial size (-Xms) are pooled, they are taken before new ones and kept on release
+// it also counts allocation volume and wakes gc when it reaches trigger or committed bytes come close to max size
+class Heap {
+    std::mutex monitor_;
+    std::atomic_size_t max_size_;
+    std::atomic_size_t committed_{ 0 };
+    size_t min_size_ = 0;
+    std::vector<Chunk *> pool_; // reserved chunks, not committed
+
+    std::atomic_size_t allocated_{ 0 }; // bytes since last take_allocated
+    std::atomic_size_t freed_{ 0 }; // bytes since last take_freed
+    std::atomic_size_t gc_trigger_{ SIZE_MAX };
+    std::mutex gc_monitor_;
+    std::condition_variable gc_request_;
+    bool gc_woken_ = false;
+    bool gc_requested_ = false; // by memory pressure
+
+    void request_gc();
+
+public:
+    Heap(size_t max_size = SIZE_MAX);
+    ~Heap();
+
+    Chunk *acquire_chunk();
+    void release_chunk(Chunk *chunk);
+
+    // accounting for memory out of chunks, commit throws OutOfMemory over max size
+    void commit(size_t num_bytes);
+    void uncommit(size_t num_bytes);
+
+    void set_max_size(size_t max_size);
+    size_t max_size();
+    size_t committed();
+
+    // chunks for min_size bytes are allocated and touched in advance, pool is kept at this size
+    void reserve(size_t min_size);
+    size_t reserved();
+
+    void note_allocation(size_t num_bytes);
+    size_t take_allocated(); // resets counter
+    size_t take_freed(); // uncommitted bytes, resets counter
+    void set_gc_trigger(size_t num_bytes);
+
+    // gc thread sleeps here, true if allocated bytes reached trigger or heap is close to max size
+    // false on timeout or wake_gc
+    bool wait_for_gc_request(std::chrono::milliseconds timeout);
+    void wake_gc(); // e.g. when interpreter finishes
+
+    static Heap &instance();
+};
+
+
+// thread local allocation buffer, allocation is a pointer bump in owned chunk without locks
+// used only by owner thread, objects of any TLAB can be freed from any thread
+class TLAB : public Allocator {
+    Heap *heap_;
+    Chunk *chunk_ = nullptr;
+    char *top_ = nullptr;
+    char *end_ = nullptr;
+    int64_t allocated_ = 0; // in current chunk
+
+    void refill();
+
+public:
+    TLAB(Heap *heap);
+    ~TLAB() override;
+
+    TLAB(const TLAB &) = delete;
+    TLAB &operator=(const TLAB &) = delete;
+
+    void *allocate(size_t num_bytes) override;
+    void deallocate(void *data) override;
+
+    // gives current chunk away, it is released to heap when all its objects are freed
+    void retire();
+};
+
+
+// old generation space of gc, objects of one size in cells, allocated cells are tracked by bitmap in chunk
+// dead cells (allocated and not marked) are finalized by sweep, which also clears marks of chunk
+// after start_sweep chunks are swept lazily: by allocate when it reaches chunk or by finish_sweep
+// sparse chunks can be evacuated for compaction, allocate does not use them until finish_evacuation
+// used only by gc thread
+class CellSpace : public Allocator {
+    struct CellChunk {
+        Chunk *chunk_;
+        bool swept_;
+        bool evacuating_ = false;
+    };
+
+    Heap *heap_;
+    size_t cell_size_;
+    void (*finalize_)(void *); // destroys dead object before its cell is reused
+    std::vector<CellChunk> chunks_;
+    size_t alloc_chunk_ = 0; // chunks before it have no free cells
+    size_t alloc_cell_ = 0; // next cell of alloc_chunk_ to try
+    size_t live_ = 0;
+
+    size_t sweep_chunk(CellChunk &c); // returns number of finalized cells
+    size_t cells_per_chunk() const;
+
+public:
+    CellSpace(Heap *heap, size_t cell_size, void (*finalize)(void *));
+    ~CellSpace() override;
+
+    CellSpace(const CellSpace &) = delete;
+    CellSpace &operator=(const CellSpace &) = delete;
+
+    void *allocate(size_t num_bytes) override;
+    void deallocate(void *data) override; // object should be destroyed already
+
+    void start_sweep(); // marks are complete
+    size_t finish_sweep(); // returns number of finalized cells, empty chunks are given back to heap
+
+    // chunks filled less than max_occupancy are chosen while rest of space has free cells for their objects
+    // returns allocated cells of chosen chunks, space should be swept
+    std::vector<void *> start_evacuation(double max_occupancy);
+    size_t finish_evacuation(); // returns number of emptied chunks given back to heap
+
+    size_t live() const;
+    size_t chunks() const;
+    double fragmentation() const; // share of free cells in chunks, dead cells which are not swept are counted as live
+};
+
+
+// size-class slabs for payloads of objects: strings, list vectors, kv tables
+// every thread allocates from its own pages without locks, blocks freed by other threads
+// (e.g. by gc sweep) are pushed to owner page atomically and picked up by owner later
+// page is uncommitted from heap when its last block is freed by owner or picked up from other threads
+constexpr size_t SLAB_PAGE_SIZE = 64 * 1024;
+constexpr size_t SLAB_MAX_BLOCK = 4096; // bigger blocks go to global new
+
+static_assert((SLAB_PAGE_SIZE & (SLAB_PAGE_SIZE - 1)) == 0);
+
+
+void *slab_allocate(size_t num_bytes);
+void slab_deallocate(void *data, size_t num_bytes);
+
+
+// stl allocator over slabs, stateless
+template <typename T>
+class SlabAllocator {
+public:
+    using value_type = T;
+
+    SlabAllocator() = default;
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U> &) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(slab_allocate(n * sizeof(T))); }
+
+    void deallocate(T *data, size_t n) { slab_deallocate(data, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U> &) const { return true; }
+};
+
+
+template <typename T, typename... Args>
+T *slab_new(Args &&...args) {
+    void *data = slab_allocate(sizeof(T));
+    try {
+        return new (data) T(std::forward<Args>(args)...);
+    } catch (...) {
+        slab_deallocate(data, sizeof(T));
+        throw;
+    }
+}
+
+
+template <typename T>
+void slab_delete(T *obj) {
+    if (obj == nullptr) {
+        return;
+    }
+    obj->~T();
+    slab_deallocate(obj, sizeof(T));
+}
+
+
+// frees object allocated by any TLAB or CellSpace
+void release(void *data);
+
+// allocator for ManagedObject-s of current thread, if none was installed thread local TLAB over Heap::instance() is used
+Allocator *current_allocator();
+void set_current_allocator(Allocator *allocator);
+
+}
@@ -1,8 +1,10 @@
 #pragma once
 
 
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "symbol.h"
 #include "utils.h"
 #include "y_objects.h"
 
@@ -12,66 +14,269 @@ class YObject;
 
 namespace yapvm::ast {
 
+// node kind tag, set at construction, used instead of rtti for dispatch
+// kinds of one category are contiguous, see is_*_kind functions
+enum class NodeKind : uint8_t {
+    // CmpOpKind
+    Eq,
+    NotEq,
+    Lt,
+    LtE,
+    Gt,
+    GtE,
+    Is,
+    IsNot,
+    In,
+    NotIn,
+
+    // UnaryOpKind
+    Invert,
+    Not,
+    USub,
+
+    // BinOpKind
+    Add,
+    Sub,
+    Mult,
+    Div,
+    Mod,
+    Pow,
+    LShift,
+    RShift,
+    BitOr,
+    BitXor,
+    BitAnd,
+    FloorDiv,
+
+    // BoolOpKind
+    And,
+    Or,
+
+    // ExprContext
+    Load,
+    Store,
+    Del,
+
+    WithItem,
+
+    // Expr
+    BoolOp,
+    BinOp,
+    UnaryOp,
+    Compare,
+    Call,
+    Constant,
+    Attribute,
+    Subscript,
+    Name,
+    List,
+    Dict,
+
+    Module,
+
+    // Stmt
+    Import,
+    FunctionDef,
+    ClassDef,
+    Return,
+    Assign,
+    AugAssign,
+    While,
+    For,
+    With,
+    If,
+    ExprStmt,
+    Pass,
+    Break,
+    Continue
+};
+
+bool is_cmp_op_kind(NodeKind kind);
+bool is_unary_op_kind(NodeKind kind);
+bool is_bin_op_kind(NodeKind kind);
+bool is_bool_op_kind(NodeKind kind);
+bool is_expr_kind(NodeKind kind);
+bool is_stmt_kind(NodeKind kind);
+
+
 class Node {
+    NodeKind kind_;
+
+protected:
+    Node(NodeKind kind) : kind_{ kind } {}
+
 public:
     virtual ~Node() = default;
+
+    NodeKind kind() const { return kind_; }
 };
 
 
-class OperatorKind : public Node {};
+class OperatorKind : public Node {
+protected:
+    OperatorKind(NodeKind kind) : Node{ kind } {}
+};
 
 
-class CmpOpKind : public OperatorKind {};
+class CmpOpKind : public OperatorKind {
+protected:
+    CmpOpKind(NodeKind kind) : OperatorKind{ kind } {}
+};
 
-class Eq : public CmpOpKind {};
-class NotEq : public CmpOpKind {};
-class Lt : public CmpOpKind {};
-class LtE : public CmpOpKind {};
-class Gt : public CmpOpKind {};
-class GtE : public CmpOpKind {};
-class Is : public CmpOpKind {};
-class IsNot : public CmpOpKind {};
-class In : public CmpOpKind {};
-class NotIn : public CmpOpKind {};
+class Eq : public CmpOpKind {
+public:
+    Eq() : CmpOpKind{ NodeKind::Eq } {}
+};
+class NotEq : public CmpOpKind {
+public:
+    NotEq() : CmpOpKind{ NodeKind::NotEq } {}
+};
+class Lt : public CmpOpKind {
+public:
+    Lt() : CmpOpKind{ NodeKind::Lt } {}
+};
+class LtE : public CmpOpKind {
+public:
+    LtE() : CmpOpKind{ NodeKind::LtE } {}
+};
+class Gt : public CmpOpKind {
+public:
+    Gt() : CmpOpKind{ NodeKind::Gt } {}
+};
+class GtE : public CmpOpKind {
+public:
+    GtE() : CmpOpKind{ NodeKind::GtE } {}
+};
+class Is : public CmpOpKind {
+public:
+    Is() : CmpOpKind{ NodeKind::Is } {}
+};
+class IsNot : public CmpOpKind {
+public:
+    IsNot() : CmpOpKind{ NodeKind::IsNot } {}
+};
+class In : public CmpOpKind {
+public:
+    In() : CmpOpKind{ NodeKind::In } {}
+};
+class NotIn : public CmpOpKind {
+public:
+    NotIn() : CmpOpKind{ NodeKind::NotIn } {}
+};
 
 
-class UnaryOpKind : public OperatorKind {};
+class UnaryOpKind : public OperatorKind {
+protected:
+    UnaryOpKind(NodeKind kind) : OperatorKind{ kind } {}
+};
 
-class Invert : public UnaryOpKind {};
-class Not : public UnaryOpKind {};
-class USub : public UnaryOpKind {};
+class Invert : public UnaryOpKind {
+public:
+    Invert() : UnaryOpKind{ NodeKind::Invert } {}
+};
+class Not : public UnaryOpKind {
+public:
+    Not() : UnaryOpKind{ NodeKind::Not } {}
+};
+class USub : public UnaryOpKind {
+public:
+    USub() : UnaryOpKind{ NodeKind::USub } {}
+};
 
 
-class BinOpKind : public OperatorKind {};
+class BinOpKind : public OperatorKind {
+protected:
+    BinOpKind(NodeKind kind) : OperatorKind{ kind } {}
+};
 
-class Add : public BinOpKind {};
-class Sub : public BinOpKind {};
-class Mult : public BinOpKind {};
-class Div : public BinOpKind {};
-class Mod : public BinOpKind {};
-class Pow : public BinOpKind {};
-class LShift : public BinOpKind {};
-class RShift : public BinOpKind {};
-class BitOr : public BinOpKind {};
-class BitXor : public BinOpKind {};
-class BitAnd : public BinOpKind {};
-class FloorDiv : public BinOpKind {};
+class Add : public BinOpKind {
+public:
+    Add() : BinOpKind{ NodeKind::Add } {}
+};
+class Sub : public BinOpKind {
+public:
+    Sub() : BinOpKind{ NodeKind::Sub } {}
+};
+class Mult : public BinOpKind {
+public:
+    Mult() : BinOpKind{ NodeKind::Mult } {}
+};
+class Div : public BinOpKind {
+public:
+    Div() : BinOpKind{ NodeKind::Div } {}
+};
+class Mod : public BinOpKind {
+public:
+    Mod() : BinOpKind{ NodeKind::Mod } {}
+};
+class Pow : public BinOpKind {
+public:
+    Pow() : BinOpKind{ NodeKind::Pow } {}
+};
+class LShift : public BinOpKind {
+public:
+    LShift() : BinOpKind{ NodeKind::LShift } {}
+};
+class RShift : public BinOpKind {
+public:
+    RShift() : BinOpKind{ NodeKind::RShift } {}
+};
+class BitOr : public BinOpKind {
+public:
+    BitOr() : BinOpKind{ NodeKind::BitOr } {}
+};
+class BitXor : public BinOpKind {
+public:
+    BitXor() : BinOpKind{ NodeKind::BitXor } {}
+};
+class BitAnd : public BinOpKind {
+public:
+    BitAnd() : BinOpKind{ NodeKind::BitAnd } {}
+};
+class FloorDiv : public BinOpKind {
+public:
+    FloorDiv() : BinOpKind{ NodeKind::FloorDiv } {}
+};
 
 
-class BoolOpKind : public OperatorKind {};
+class BoolOpKind : public OperatorKind {
+protected:
+    BoolOpKind(NodeKind kind) : OperatorKind{ kind } {}
+};
 
-class And : public BoolOpKind {};
-class Or : public BoolOpKind {};
+class And : public BoolOpKind {
+public:
+    And() : BoolOpKind{ NodeKind::And } {}
+};
+class Or : public BoolOpKind {
+public:
+    Or() : BoolOpKind{ NodeKind::Or } {}
+};
 
 
-class ExprContext : public Node {};
+class ExprContext : public Node {
+protected:
+    ExprContext(NodeKind kind) : Node{ kind } {}
+};
 
-class Load : public ExprContext {};
-class Store : public ExprContext {};
-class Del : public ExprContext {};
+class Load : public ExprContext {
+public:
+    Load() : ExprContext{ NodeKind::Load } {}
+};
+class Store : public ExprContext {
+public:
+    Store() : ExprContext{ NodeKind::Store } {}
+};
+class Del : public ExprContext {
+public:
+    Del() : ExprContext{ NodeKind::Del } {}
+};
 
 
-class Expr : public Node {};
+class Expr : public Node {
+protected:
+    Expr(NodeKind kind) : Node{ kind } {}
+};
 
 
 class WithItem : public Node {
@@ -164,7 +369,7 @@ public:
 
 class Attribute : public Expr {
     scoped_ptr<Expr> value_;
-    std::string attr_;
+    Symbol attr_;
     scoped_ptr<ExprContext> ctx_;
 
 public:
@@ -172,7 +377,7 @@ public:
 
     const scoped_ptr<ExprContext> &ctx() const;
     const scoped_ptr<Expr> &value() const;
-    const std::string &attr() const;
+    Symbol attr() const;
 };
 
 
@@ -191,21 +396,30 @@ public:
 
 
 class Name : public Expr {
-    std::string id_;
+    Symbol id_;
     scoped_ptr<ExprContext> ctx_;
 
 public:
     Name(std::string &&id, scoped_ptr<ExprContext> &&ctx);
 
     const scoped_ptr<ExprContext> &ctx() const;
-    const std::string &id() const;
+    Symbol id() const;
 };
 
-class List : public Expr {};
-class Dict : public Expr {};
+class List : public Expr {
+public:
+    List() : Expr{ NodeKind::List } {}
+};
+class Dict : public Expr {
+public:
+    Dict() : Expr{ NodeKind::Dict } {}
+};
 
 
-class Stmt : public Node {};
+class Stmt : public Node {
+protected:
+    Stmt(NodeKind kind) : Node{ kind } {}
+};
 
 
 class Module : public Node {
@@ -232,7 +446,7 @@ public:
 
 class FunctionDef : public Stmt {
     std::string name_;
-    std::vector<std::string> args_;
+    std::vector<Symbol> args_;
     std::vector<scoped_ptr<Stmt>> body_;
     scoped_ptr<Expr> returns_; // just nullptr if nothing
 
@@ -242,7 +456,7 @@ public:
                 scoped_ptr<Expr> &&returns);
 
     const std::string &name() const;
-    const std::vector<std::string> &args() const;
+    const std::vector<Symbol> &args() const;
     const std::vector<scoped_ptr<Stmt>> &body() const;
     const scoped_ptr<Expr> &returns() const;
     bool returns_anything() const;
@@ -354,9 +568,18 @@ public:
     const scoped_ptr<Expr> &value() const;
 };
 
-class Pass : public Stmt {};
-class Break : public Stmt {};
-class Continue : public Stmt {};
+class Pass : public Stmt {
+public:
+    Pass() : Stmt{ NodeKind::Pass } {}
+};
+class Break : public Stmt {
+public:
+    Break() : Stmt{ NodeKind::Break } {}
+};
+class Continue : public Stmt {
+public:
+    Continue() : Stmt{ NodeKind::Continue } {}
+};
 
 
 } // namespace yapvm::ast
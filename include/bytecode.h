@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "scope.h"
+#include "utils.h"
+#include "y_objects.h"
+
+/**
+ * Flat stack-based bytecode, produced by compiler::compile from ast::Module
+ * and executed by Interpreter dispatch loop instead of walking the tree.
+ *
+ * Every value produced by an instruction lives on the interpreter operand stack,
+ * so stack is a gc root between instructions. Primitives are immediate Values
+ * and never allocate
+ */
+
+namespace yapvm::bytecode {
+
+using yobjects::ManagedObject;
+using yobjects::Value;
+
+
+enum OpCode : uint8_t {
+    OP_NOP,
+    OP_SAFEPOINT,
+
+    OP_LOAD_CONST,          // arg: index in consts_
+    OP_LOAD_NAME,           // arg: index in names_, free names looked up through scope chain
+    OP_LOAD_FAST,           // arg: index in locals_
+    OP_STORE_FAST,          // arg: index in locals_
+    OP_POP,
+
+    OP_BINARY,              // arg: BinaryOperator
+    OP_UNARY,               // arg: UnaryOperator
+    OP_COMPARE,             // arg: CompareOperator
+    OP_BOOL_AND,            // arg: number of values on stack
+    OP_BOOL_OR,             // arg: number of values on stack
+
+    OP_JUMP,                // arg: target instruction
+    OP_POP_JUMP_IF_FALSE,   // arg: target instruction
+
+    OP_LOAD_SUBSCR,
+    OP_STORE_SUBSCR,
+    OP_LIST_APPEND,         // list.append(x)
+    OP_INPLACE_ADD,         // list += x
+    OP_BUILD_LIST,
+
+    OP_PRINT,
+    OP_CONVERT,             // arg: Conversion
+
+    OP_MAKE_FUNCTION,       // arg: index in functions_
+    OP_CALL,                // arg: index in call_sites_
+    OP_THREAD_SPAWN,        // arg: index in call_sites_
+    OP_THREAD_JOIN,
+    OP_RETURN_VALUE,
+    OP_RETURN_NONE,
+
+    OP_RAISE                // arg: index in messages_
+};
+
+
+enum BinaryOperator : uint8_t {
+    BINARY_ADD,
+    BINARY_SUB,
+    BINARY_MULT,
+    BINARY_DIV,
+    BINARY_MOD,
+    BINARY_POW,
+    BINARY_LSHIFT,
+    BINARY_RSHIFT,
+    BINARY_BITOR,
+    BINARY_BITXOR,
+    BINARY_BITAND,
+    BINARY_FLOORDIV
+};
+
+
+enum UnaryOperator : uint8_t {
+    UNARY_INVERT,
+    UNARY_NOT,
+    UNARY_USUB
+};
+
+
+enum CompareOperator : uint8_t {
+    CMP_EQ,
+    CMP_NOTEQ,
+    CMP_LT,
+    CMP_LTE,
+    CMP_GT,
+    CMP_GTE,
+    CMP_IS,
+    CMP_ISNOT,
+    CMP_IN,
+    CMP_NOTIN
+};
+
+
+enum Conversion : uint8_t {
+    CONV_STR,
+    CONV_INT,
+    CONV_FLOAT
+};
+
+
+struct Instruction {
+    OpCode op_;
+    uint32_t arg_;
+};
+
+
+// call site resolved at compile time, callee itself resolved in runtime by name
+struct CallSite {
+    uint32_t name_;         // index in names_ of callee scope entry name
+    uint32_t argc_;
+};
+
+
+// callee resolved at call site for scope of calling thread (by Scope::id), valid while Scope::functions_epoch is unchanged
+// entry is a seqlock, version is odd while entry is written, so threads share caches without locks
+struct CallCacheEntry {
+    std::atomic_uint32_t version_{ 0 };
+    std::atomic_uint64_t scope_{ 0 }; // ids of scopes start from 1
+    std::atomic<ast::FunctionDef *> callee_{ nullptr };
+    std::atomic_uint64_t epoch_{ 0 };
+};
+
+
+// inline cache of call site, site is polymorphic when it was resolved for more than one scope
+class CallCache {
+public:
+    static constexpr uint32_t WAYS = 4;
+
+private:
+    CallCacheEntry entries_[WAYS];
+    std::atomic_uint32_t used_{ 0 };
+    std::atomic_uint32_t victim_{ 0 }; // round robin replacement when all ways are used
+
+public:
+    // nullptr on miss
+    ast::FunctionDef *find(uint64_t scope, uint64_t epoch, bool &polymorphic) const;
+    // epoch should be read before callee lookup, so entry from lookup racing with function change is stale
+    void insert(uint64_t scope, ast::FunctionDef *callee, uint64_t epoch);
+};
+
+
+struct CallCacheStats {
+    uint64_t monomorphic_ = 0;
+    uint64_t polymorphic_ = 0;
+    uint64_t misses_ = 0;
+
+    CallCacheStats &operator+=(const CallCacheStats &other);
+    std::string summary() const;
+};
+
+
+// interpreters add their counters when finished
+void add_call_cache_stats(const CallCacheStats &stats);
+CallCacheStats call_cache_stats();
+
+
+// heap consts_ are owned by CodeObject and never registered in gc, so they are not collected
+struct CodeObject {
+    std::string name_;
+    const ast::FunctionDef *def_ = nullptr; // nullptr for module code
+    std::vector<Instruction> code_;
+    std::vector<Value> consts_;
+    interpreter::SlotLayout locals_; // args first, then names assigned in code, module code keeps globals here
+    std::vector<Symbol> names_;
+    std::vector<std::string> messages_;
+    std::vector<const ast::FunctionDef *> functions_;
+    std::vector<CallSite> call_sites_;
+    std::unique_ptr<CallCache[]> call_caches_; // one per call site, shared by all threads
+
+    CodeObject(std::string name, const ast::FunctionDef *def);
+    ~CodeObject();
+
+    CodeObject(const CodeObject &) = delete;
+    CodeObject &operator=(const CodeObject &) = delete;
+
+    void init_call_caches(); // when code is compiled
+};
+
+
+// compiled module with all function bodies it contains
+class Program {
+    scoped_ptr<CodeObject> module_;
+    std::vector<scoped_ptr<CodeObject>> functions_;
+    std::unordered_map<const ast::FunctionDef *, CodeObject *> by_def_;
+
+public:
+    Program(scoped_ptr<CodeObject> &&module);
+
+    Program(const Program &) = delete;
+    Program &operator=(const Program &) = delete;
+
+    void add_function(scoped_ptr<CodeObject> &&function);
+
+    const CodeObject *module() const;
+    const CodeObject *function_code(const ast::FunctionDef *def) const;
+};
+
+
+BinaryOperator binary_operator(const ast::BinOpKind *op);
+UnaryOperator unary_operator(const ast::UnaryOpKind *op);
+CompareOperator compare_operator(const ast::CmpOpKind *op);
+
+const char *opcode_name(OpCode op);
+
+std::string disassemble(const CodeObject &code);
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ast.h"
+#include "bytecode.h"
+#include "utils.h"
+
+
+namespace yapvm::compiler {
+
+using namespace yapvm::ast;
+
+// lowers module and every function body in it to bytecode, module stays owner of ast
+scoped_ptr<bytecode::Program> compile(Module *module);
+
+} // namespace yapvm::compiler
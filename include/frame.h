@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "scope.h"
+
+namespace yapvm::interpreter {
+
+// call of bytecode function, args and locals are slots of its code object layout
+// free names are looked up in callers first and then in scope of thread, as with scope per call before
+struct Frame {
+    Frame *caller_;
+    const bytecode::CodeObject *code_;
+    Scope *dynamic_; // entries made while frame runs, e.g. nested functions, created on first use
+    size_t prev_block_; // stack top before push
+    size_t prev_top_;
+    uint32_t slots_count_;
+
+    Value *slots() { return reinterpret_cast<Value *>(this + 1); }
+
+    Scope *dynamic_scope();
+
+    std::optional<ScopeEntry> get(Symbol name);
+};
+
+
+// frames of one thread in contiguous blocks, push and pop are pointer bumps and blocks are reused
+class FrameStack {
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+
+    struct Block {
+        std::unique_ptr<std::byte[]> data_;
+        size_t size_ = 0;
+    };
+
+    std::vector<Block> blocks_;
+    size_t block_ = 0;
+    size_t top_ = 0; // in blocks_[block_]
+
+public:
+    FrameStack() = default;
+
+    FrameStack(const FrameStack &) = delete;
+    FrameStack &operator=(const FrameStack &) = delete;
+
+    Frame *push(const bytecode::CodeObject *code, Frame *caller); // slots are unbound
+    void pop(Frame *frame); // only the last pushed frame
+};
+
+} // namespace yapvm::interpreter
@@ -1,12 +1,24 @@
 #pragma once
 
+#include "allocator.h"
+#include "gc_stats.h"
+#include "heap_dump.h"
+#include "object_list.h"
 #include "y_objects.h"
 #include "scope.h"
 #include "thread_manager.h"
+#include <functional>
 #include <string>
 #include <vector>
 
 #define GC_CASH_LIMIT 5000
+#define GC_NURSERY_BYTES (1024 * 1024) // allocated bytes which trigger gc cycle, nursery adapts to survival rate
+#define GC_NURSERY_MAX_BYTES (16 * 1024 * 1024)
+#define GC_HEAP_GROWTH 2 // next major collection when old generation grows so many times over live objects
+#define GC_IDLE_CHECK_MS 100 // without allocations gc only checks that interpreters are alive
+#define GC_COMPACT_FRAGMENTATION 0.5 // share of free cells in old space after sweep which requests compaction
+#define GC_COMPACT_MIN_CHUNKS 4 // smaller old space is not compacted
+#define GC_COMPACT_OCCUPANCY 0.5 // old space chunks filled less are evacuated
 
 // TODO need to register all ManagedObject allocations
 // TODO Only GC can clean ManagedObject
@@ -19,26 +31,85 @@ namespace yapvm::ygc {
 class YGC {
     ThreadManager *tm_;
     Scope *root_;
-    std::vector<ManagedObject *> left_{};
+    std::vector<ManagedObject *> left_{}; // old objects out of old_space_ (promoted in place, filled by tests)
     std::vector<ManagedObject *> right_{};
+    ObjectList young_{}; // nursery, registration logs of interpreters spliced since last minor collection
+    std::vector<ManagedObject *> untracked_marked_{}; // marked objects out of generations, unmarked by sweep
+    std::vector<ManagedObject *> snapshot_{}; // roots taken by initial mark
+    size_t old_limit_{ GC_CASH_LIMIT }; // old generation size which triggers major collection
+    size_t nursery_bytes_{ GC_NURSERY_BYTES };
+    size_t mark_threads_{ 0 }; // 0 - by hardware concurrency
 
-    bool need_check_hs_ = false;
-    size_t max_hs_ = -1;
+    memory::Heap *heap_; // chunks for interpreters TLABs, max heap size is checked there
+    // survivors of minor collections are copied here, swept lazily over chunk bitmaps after major mark
+    memory::CellSpace old_space_{ &memory::Heap::instance(), sizeof(ManagedObject), finalize };
+    bool sweep_pending_{ false };
+    bool compaction_{ true };
+    bool compact_pending_{ false }; // fragmentation was measured over limit, compaction is done in next pause
+    bool compacted_{ false }; // pinned objects may keep space fragmented, it is not compacted again right away
+    GCStats stats_;
+    CycleStats cycle_; // filled by phases of current cycle
+    std::string heap_dump_path_; // rewritten after every major mark, empty - no dumps
+    bool heap_dumped_{ false }; // runs without major collection are dumped at exit
+
+    static void finalize(void *obj);
+
+    // roots are visited in place, so gc can update them, scopes of live interpreters are visited by them
+    void visit_roots(const std::function<void(Value &)> &visit);
+    std::vector<ManagedObject *> roots();
+    // roots of mutators are scanned by marker threads in parallel
+    void trace(const std::vector<ManagedObject *> &gray, const std::string &phase,
+               const std::vector<Interpreter *> &mutators = {});
+    // checked before parking, allocations may be only payloads of old objects, e.g. growing list
+    bool has_work();
 public:
     YGC(Scope *root, ThreadManager *tm) : root_(root), tm_(tm),
-    left_(std::vector<ManagedObject *>()), right_(std::vector<ManagedObject *>()) {};
+    left_(std::vector<ManagedObject *>()), right_(std::vector<ManagedObject *>()),
+          heap_(&memory::Heap::instance()) {};
 
     YGC(Scope *root, ThreadManager *tm, size_t max_hs) : root_(root), tm_(tm),
     left_(std::vector<ManagedObject *>()), right_(std::vector<ManagedObject *>()),
-          max_hs_(max_hs), need_check_hs_(true) {};
+          heap_(&memory::Heap::instance()) {
+        heap_->set_max_size(max_hs);
+    };
 
+    // copies live young objects to old generation and frees the rest of nursery
+    // roots are scopes, operand stacks and remembered set, old objects are not traced
+    void minor();
+    // parallel, marker threads share gray objects through work-stealing deques
     void mark();
     void sweep();
     void collect();
 
+    // major collection with concurrent mark, interpreters are parked only in initial mark and remark
+    // initial mark takes roots snapshot, objects unreachable since then are still found via satb log
+    void initial_mark();
+    void concurrent_mark();
+    void remark();
+
+    // stop-the-world mark-compact of old space, nursery should be empty
+    // live objects of sparse chunks are moved to other chunks, references in roots and objects are forwarded
+    // objects referenced by dicts are not moved, as they are found by address in dict storage
+    void compact();
+    void set_compaction(bool enabled);
+    double fragmentation() const;
+
+    GCStats &stats(); // json lines of cycles are written to stats file if it is opened
+
+    // live graph from roots by the same edges as marker follows, interpreters should be parked
+    void dump_heap(const std::string &path);
+    void set_heap_dump(const std::string &path);
+
+    void set_mark_threads(size_t n);
+    size_t mark_threads() const;
+
     // TODO function only for testing, will be deprecated
     void fill_left(std::vector<ManagedObject *> &);
+    void fill_young(std::vector<ManagedObject *> &);
     std::vector<ManagedObject *> &left();
+    size_t old_objects() const; // dead objects which are not swept yet are counted
+    size_t nursery_budget() const; // small max heap size gets smaller nursery, so gc runs before max is reached
+    ObjectList &young();
 };
 
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace yapvm::ygc {
+
+// one gc cycle, from parking of interpreters until its concurrent work (concurrent mark or lazy sweep) is done
+struct CycleStats {
+    size_t cycle_ = 0;
+    std::string kind_; // phases done in pause, e.g. minor+initial_mark
+    uint64_t ttsp_ns_ = 0; // time to safepoint
+    uint64_t pause_ns_ = 0; // interpreters are parked, time to safepoint included
+    uint64_t mark_ns_ = 0; // concurrent mark included
+    uint64_t sweep_ns_ = 0; // lazy sweep included
+    size_t allocated_bytes_ = 0; // committed since previous cycle
+    size_t freed_bytes_ = 0; // uncommitted since previous cycle
+    size_t committed_bytes_ = 0; // at the end of cycle
+    size_t promoted_objects_ = 0;
+    size_t live_objects_ = 0; // old generation at the end of cycle, not swept objects are counted
+
+    std::string to_json() const;
+};
+
+
+// per cycle stats of gc, readable from other threads while gc runs
+// with stats file every cycle is written there as json line, summary is the last line
+class GCStats {
+    mutable std::mutex monitor_;
+    std::vector<CycleStats> cycles_;
+    std::ofstream out_;
+
+public:
+    void open(const std::string &path);
+    void record(CycleStats stats);
+
+    std::vector<CycleStats> cycles() const;
+    uint64_t pause_percentile(double p) const; // nearest rank, 0 without cycles
+    std::string summary() const; // pause p50/p99/max and totals
+    void finish(); // writes summary to stats file
+};
+
+} // namespace yapvm::ygc
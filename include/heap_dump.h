@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace yapvm::ygc {
+
+// snapshot of live object graph for offline analysis, written by YGC::dump_heap and read by yapvm_heap_summary
+// binary format, native byte order:
+//   magic "YHDP", u32 version
+//   u32 types count, then per type: u32 id, u32 name length, name bytes
+//   u64 roots count, u64 object index per root
+//   u64 objects count, then per object: u32 type id, u64 size, u32 edges count, u64 object index per edge
+struct HeapDump {
+    static constexpr char MAGIC[4] = { 'Y', 'H', 'D', 'P' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Object {
+        uint32_t type_id_;
+        uint64_t size_; // shallow, object header and its payload
+        std::vector<uint64_t> edges_; // list elements, fields and dict entries
+    };
+
+    std::map<uint32_t, std::string> type_names_;
+    std::vector<uint64_t> roots_;
+    std::vector<Object> objects_;
+
+    void write(const std::string &path) const;
+    static HeapDump read(const std::string &path);
+
+    // size of objects which are freed with given one, by dominator tree of graph from roots
+    std::vector<uint64_t> retained_sizes() const;
+    // per type counts and sizes, then objects with top retained sizes
+    std::string summary(size_t top) const;
+};
+
+} // namespace yapvm::ygc
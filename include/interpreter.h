@@ -1,25 +1,32 @@
 #pragma once
 
 #include <atomic>
-#include <stack>
 #include <thread>
+#include "allocator.h"
 #include "ast.h"
+#include "bytecode.h"
+#include "frame.h"
+#include "object_list.h"
 
 #include "scope.h"
 #include "thread_manager.h"
 
-//TODO add xmx xms
-
 namespace yapvm::interpreter {
 using namespace yapvm::ast;
 
+
+enum ExecMode {
+    BYTECODE,
+    TREE_WALKER // old ast interpreter, kept for A/B comparisons
+};
+
+
 //TODO stack of executing now loops (and functions probably for stacktrace???)
 class Interpreter {
     Module *code_;
     Scope *scope_; // it is a current working scope
     Scope *main_scope_; // main scope for current interpreter, there can be other scopes
     std::atomic_bool parked_ = false;
-    std::atomic_bool need_unpark_ = false;
     std::atomic_bool need_park_ = false;
 
     std::atomic_bool finishing_ = false;
@@ -28,34 +35,76 @@ class Interpreter {
 
     ThreadManager *thread_manager_;
 
-    std::stack<ManagedObject *> register_queue_;
+    ygc::ObjectList register_queue_; // objects allocated since last gc cycle, taken by gc as a whole
+    std::atomic_size_t registered_ = 0; // size of register_queue_, gc reads it while interpreter runs
+    memory::TLAB tlab_{ &memory::Heap::instance() }; // installed for ManagedObject-s while worker runs
+
+    scoped_ptr<bytecode::Program> program_; // nullptr in TREE_WALKER mode
+    const bytecode::CodeObject *entry_ = nullptr;
+    std::vector<Value> stack_; // operand stack, heap values in it are gc roots
+    FrameStack frames_;
+    Frame *frame_ = nullptr; // current call, nullptr while entry code runs in scope_
+    size_t dynamic_frames_ = 0; // frames with own entries, call sites are not cached while there are any
+    bytecode::CallCacheStats call_cache_stats_;
 
     void __worker_exec(Module *code);
 
+    // pushes result on operand stack, operands stay there while other operands are evaluated,
+    // so gc finds and moves them if evaluation calls a function
     void interpret_expr(Expr *code);
 
     bool interpret_stmt(Stmt *code);
 
     bool interpret(Node *code);
 
-    void handle_safepoint();
+    Value exec_code(const bytecode::CodeObject *code);
+
+    // frames of calls from the last one, then scope chain
+    ScopeEntry name_lookup(Symbol name);
+
+    // through inline cache of call site, nullptr if name is not a function
+    FunctionDef *resolve_callee(const bytecode::CodeObject *code, uint32_t site_idx);
+
+    Value spawn_thread(FunctionDef *callee, Value arg);
+
+    void join_thread(Value thread_object);
+
+    // immediates never reach gc, only heap values are queued
+    void register_value(Value value);
+
+    // polled at function entry, loop back-edges and statements, fast path is a single load
+    void handle_safepoint() {
+        if (need_park_.load(std::memory_order_acquire)) [[unlikely]] {
+            park_at_safepoint();
+        }
+    }
+
+    void park_at_safepoint();
+
+    Interpreter(bytecode::Program *program, const bytecode::CodeObject *entry, ThreadManager *tm, Scope *scope);
 
 public:
-    Interpreter(scoped_ptr<Module> &&code, ThreadManager *tm, Scope *scope = new Scope{});
+    Interpreter(scoped_ptr<Module> &&code, ThreadManager *tm, Scope *scope = new Scope{}, ExecMode mode = BYTECODE);
     ~Interpreter();
 
     void park();
     bool is_parked() const;
-    void run();
 
-    void launch();
+    void launch(Interpreter *parent = nullptr); // registers interpreter in thread manager and starts it
 
     bool is_finished() const;
     void join();
 
     Scope *get_scope() const;
 
-    std::vector<yobjects::ManagedObject *> get_register_queue();
+    std::vector<Value> &get_stack(); // gc updates references to moved objects
+    const std::vector<Value> &get_stack() const;
+
+    // frames and temporaries of this thread, scopes of other live threads are not visited
+    void visit_roots(const std::function<void(Value &)> &visit);
+
+    ygc::ObjectList take_register_queue(); // only while interpreter is parked
+    size_t registered() const; // objects in register queue, may be behind while interpreter runs
 };
 
 
@@ -349,4 +349,14 @@ public:
 	    }
 	    return live_entries;
 	}
+
+    // same as get_live_entries_values, but without materialising them
+    template <typename F>
+    void for_each_live_value(F &&visit) {
+        for (size_t i = 0; i < capacity(); i++) {
+            if (_data[i].exists && !_data[i].deleted) {
+                visit(_data[i].value);
+            }
+        }
+    }
 };
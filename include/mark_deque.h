@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace yapvm::yobjects {
+class ManagedObject;
+}
+
+namespace yapvm::ygc {
+
+// Chase-Lev work-stealing deque of gray objects for parallel mark
+// owner pushes and pops at bottom, other markers steal from top
+class MarkDeque {
+    struct Buffer {
+        int64_t capacity_; // power of two
+        std::unique_ptr<std::atomic<yobjects::ManagedObject *>[]> items_;
+
+        explicit Buffer(int64_t capacity);
+
+        yobjects::ManagedObject *get(int64_t idx) const;
+        void put(int64_t idx, yobjects::ManagedObject *obj);
+    };
+
+    std::atomic<int64_t> top_{ 0 };
+    std::atomic<int64_t> bottom_{ 0 };
+    std::atomic<Buffer *> buffer_;
+    std::vector<std::unique_ptr<Buffer>> buffers_; // outgrown buffers may still be read by thieves, freed with deque
+
+    Buffer *grow(Buffer *old, int64_t bottom, int64_t top);
+
+public:
+    explicit MarkDeque(int64_t capacity = 1024);
+
+    MarkDeque(const MarkDeque &) = delete;
+    MarkDeque &operator=(const MarkDeque &) = delete;
+
+    // owner only
+    void push(yobjects::ManagedObject *obj);
+    yobjects::ManagedObject *pop(); // nullptr if empty
+
+    // any thread, nullptr if empty or race with other thief or owner is lost
+    yobjects::ManagedObject *steal();
+
+    bool empty() const;
+};
+
+} // namespace yapvm::ygc
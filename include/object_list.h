@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+namespace yapvm::yobjects {
+class ManagedObject;
+}
+
+namespace yapvm::ygc {
+
+// list of objects in fixed-size segments, used as per-thread log of allocations and as nursery of gc
+// owner appends without locks, whole list is taken over by another list in O(1) while owner is parked
+class ObjectList {
+    struct Segment {
+        Segment *next_;
+        size_t size_;
+        yobjects::ManagedObject *objects_[1];
+    };
+
+    Segment *head_ = nullptr; // filled by push, older segments follow it
+    Segment *tail_ = nullptr;
+    size_t size_ = 0;
+
+    void grow();
+
+public:
+    // segment is one slab block, so its allocation and free are pointer bumps in owner slab page
+    static constexpr size_t SEGMENT_BYTES = 4096;
+    static constexpr size_t SEGMENT_OBJECTS = (SEGMENT_BYTES - sizeof(Segment)) / sizeof(yobjects::ManagedObject *) + 1;
+
+    ObjectList() = default;
+    ~ObjectList();
+
+    ObjectList(ObjectList &&other) noexcept;
+    ObjectList &operator=(ObjectList &&other) noexcept;
+
+    ObjectList(const ObjectList &) = delete;
+    ObjectList &operator=(const ObjectList &) = delete;
+
+    void push(yobjects::ManagedObject *obj) {
+        if (head_ == nullptr || head_->size_ == SEGMENT_OBJECTS) {
+            grow();
+        }
+        head_->objects_[head_->size_++] = obj;
+        size_++;
+    }
+
+    void splice(ObjectList &&other); // takes all objects of other, segments are not copied
+    void clear(); // objects are not touched
+
+    template <typename F>
+    void for_each(F &&visit) const {
+        for (Segment *s = head_; s != nullptr; s = s->next_) {
+            for (size_t i = 0; i < s->size_; i++) {
+                visit(s->objects_[i]);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+};
+
+} // namespace yapvm::ygc
@@ -1,8 +1,13 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "kvstorage.h"
+#include "symbol.h"
 #include "y_objects.h"
 
 using namespace yapvm::yobjects;
@@ -21,48 +26,84 @@ enum ScopeEntryType {
 
 
 struct ScopeEntry {
-    void *value_;
+    void *value_;           // FunctionDef or Scope, unused for OBJECT
     ScopeEntryType type_;
+    Value object_{};        // OBJECT only, immediates are stored right here
 };
 
 bool operator==(const ScopeEntry &a, const ScopeEntry &b);
 
 
+// names resolved to fixed slots at compile time, one layout is shared by all scopes of a code object
+struct SlotLayout {
+    std::vector<Symbol> names_;
+    std::unordered_map<Symbol, uint32_t> index_;
+
+    uint32_t add(Symbol name); // known name keeps its slot
+    std::optional<uint32_t> find(Symbol name) const;
+};
+
+
 // Scope can't manage FunctionDef and ManagedObject lifetimes; Delegate to gc
 // copy constructor IF NEEDED
 class Scope {
     Scope* parent_;
-    KVStorage<std::string, ScopeEntry> scope_;
+    SlabKVStorage<Symbol, ScopeEntry> scope_;
+    bool thread_root_ = false; // main scope of registered interpreter, changed only out of stop-the-world
+    const SlotLayout *layout_ = nullptr;
+    std::vector<Value, memory::SlabAllocator<Value>> slots_; // unbound slots hold null reference
+
+    Value *slot_of(Symbol name); // nullptr if name has no slot
+
+    static std::atomic_uint64_t next_id_;
+    static std::atomic_uint64_t functions_epoch_;
+    const uint64_t id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
+    bool frame_local_ = false;
+    void function_changed();
 
 public:
-    constexpr static const char *lst_exec_res = "__yapvm_inner_last_exec_res";
     constexpr static const char *yapvm_thread_func_name = "__yapvm_thread";
     constexpr static const char *yapvm_thread_join_func_name = "__yapvm_thread_join";
 
     Scope();
     Scope(Scope *parent) : parent_{ parent } {};
 
-    bool add_object(std::string name, ManagedObject *value);
-    bool add_function(std::string signature, FunctionDef *function);
-    bool add_child_scope(std::string name, Scope *subscope);
-    bool add(std::string name, ScopeEntry entry);
+    bool add_object(Symbol name, Value value);
+    bool add_function(Symbol signature, FunctionDef *function);
+    bool add_child_scope(Symbol name, Scope *subscope);
+    bool add(Symbol name, ScopeEntry entry);
+
+    void change(Symbol name, ScopeEntry new_entry);
+    void del(Symbol name);
+
+    ScopeEntry name_lookup(Symbol name);
 
-    void change(const std::string &name, ScopeEntry new_entry);
-    void del(const std::string &name);
-    void store_last_exec_res(const std::string &name);
-    void update_last_exec_res(ManagedObject *value);
+    // names of layout are kept in slots from now, lookups by name still find them
+    void bind_slots(const SlotLayout *layout);
+    Value &slot(uint32_t idx) { return slots_[idx]; }
+    Value *slots() { return slots_.data(); }
+    static bool is_unbound(const Value &value) { return value.is_object() && value.object() == nullptr; }
 
-    ScopeEntry name_lookup(const std::string &name);
+    // changed after any function entry of any scope is added, changed or deleted, so cached lookups are stale
+    static uint64_t functions_epoch() { return functions_epoch_.load(std::memory_order_acquire); }
+    // never reused, unlike address of deleted scope, so cached lookups are keyed on it
+    uint64_t id() const { return id_; }
+    // entries of call frame, lookups through frames are never cached, so its functions leave epoch as is
+    void set_frame_local() { frame_local_ = true; }
 
     static std::string scope_entry_function_name(const std::string &name);
     static std::string scope_entry_call_subscope_name(const std::string &name);
     static std::string scope_entry_thread_name(size_t id);
 
-    ManagedObject *get_object(const std::string &name);
-    FunctionDef *get_function(const std::string &signature);
-    std::optional<ScopeEntry> get(const std::string &name);
+    ManagedObject *get_object(Symbol name); // nullptr for immediates
+    FunctionDef *get_function(Symbol signature);
+    std::optional<ScopeEntry> get(Symbol name);
     std::vector<Scope *> get_all_children() const;
-    std::vector<ManagedObject*> get_all_objects() const;
+    std::vector<ManagedObject*> get_all_objects() const; // heap objects only
+    // object entries of this scope and children, children which are thread roots are left to their interpreters
+    void visit_values(const std::function<void(Value &)> &visit);
+    void set_thread_root(bool thread_root);
+    bool is_thread_root() const;
     std::vector<std::pair<std::string, ScopeEntry>> get_all() const;
     Scope *parent() const;
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace yapvm {
+
+// interned identifier, all symbols of one name share a record which lives as long as vm,
+// so symbols are compared by pointer and hashed without reading the name
+// strings convert implicitly and are interned on the way, hot paths keep symbols made at parse and compile time
+class Symbol {
+public:
+    struct Record {
+        std::string name_;
+        size_t hash_;
+    };
+
+private:
+    const Record *record_;
+
+public:
+    Symbol(); // empty name
+    Symbol(std::string_view name);
+    Symbol(const std::string &name) : Symbol{ std::string_view{ name } } {}
+    Symbol(const char *name) : Symbol{ std::string_view{ name } } {}
+
+    const std::string &str() const { return record_->name_; }
+    size_t hash() const { return record_->hash_; }
+
+    bool operator==(const Symbol &other) const { return record_ == other.record_; }
+};
+
+std::ostream &operator<<(std::ostream &out, const Symbol &symbol);
+
+size_t interned_symbols_count();
+
+} // namespace yapvm
+
+
+template <>
+struct std::hash<yapvm::Symbol> {
+    size_t operator()(const yapvm::Symbol &symbol) const noexcept { return symbol.hash(); }
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <mutex>
 #include <optional>
@@ -7,12 +9,32 @@
 namespace yapvm::interpreter {
 class Interpreter;
 
+
+// stop-the-world latencies, entry is time to safepoint of the slowest interpreter
+struct SafepointStats {
+    size_t stops{ 0 };
+    uint64_t ttsp_last_ns{ 0 };
+    uint64_t ttsp_max_ns{ 0 };
+    uint64_t ttsp_total_ns{ 0 };
+    uint64_t resume_max_ns{ 0 };
+    uint64_t resume_total_ns{ 0 };
+};
+
 // not thread-safe, there can be only one instance in gc
 class ThreadManager {
     std::mutex monitor_;
     std::vector<Interpreter *> interpreters_;
     std::deque<Interpreter *> join_queue_;
 
+    // epoch is odd while world is stopped, parked interpreters sleep until it changes
+    std::mutex safepoint_monitor_;
+    std::condition_variable parked_cv_;
+    std::condition_variable resume_cv_;
+    uint64_t epoch_{ 0 };
+    size_t parked_{ 0 };
+    size_t in_safe_region_{ 0 }; // counted as parked, they do not wait for run_all
+    SafepointStats stats_{};
+
 public:
     bool register_interpreter(Interpreter *interpreter);
     bool unregister_interpreter(Interpreter *interpreter);
@@ -22,8 +44,29 @@ public:
     std::optional<bool> is_all_parked();
     bool run_all();
 
+    // called by interpreter at safepoint after park request, returns when world is resumed
+    void block_at_safepoint();
+    SafepointStats safepoint_stats();
+
+    // thread in safe region does not touch heap and operand stack, stop-the-world does not wait for it
+    void enter_safe_region();
+    void leave_safe_region(); // blocks while world is stopped
+
     bool finish_waiting();
     std::optional<bool> is_registered(Interpreter *);
 };
 
+
+// long native operations are guarded by it, so their time is not added to time to safepoint
+class SafeRegion {
+    ThreadManager *tm_;
+
+public:
+    explicit SafeRegion(ThreadManager *tm);
+    ~SafeRegion();
+
+    SafeRegion(const SafeRegion &) = delete;
+    SafeRegion &operator=(const SafeRegion &) = delete;
+};
+
 }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
+#include "allocator.h"
 #include "ast.h"
 #include "kvstorage.h"
+#include "symbol.h"
 #include "utils.h"
 
 /**
@@ -32,70 +37,135 @@ class FunctionDef;
 namespace yapvm::yobjects {
 
 class ManagedObject;
+class Value;
+
+
+// remembered set of minor gc, old objects which got references to young ones
+void remember(ManagedObject *old_object);
+std::vector<ManagedObject *> take_remembered();
+
+// snapshot-at-the-beginning log of concurrent mark, set between initial mark and remark
+// references overwritten by mutators meanwhile are logged so marker still sees them
+inline std::atomic_bool marking_active{ false };
+void satb_enqueue(ManagedObject *overwritten);
+std::vector<ManagedObject *> take_satb();
+
+
+// payload containers live in size-class slabs, see memory::slab_allocate
+template <typename K, typename V, typename Hash = std::hash<K>>
+using SlabKVStorage = KVStorage<K, V, 70, 30, Hash, 10, std::equal_to<K>, memory::SlabAllocator<KVStorageElement<K, V>>>;
+
+using YString = std::basic_string<char, std::char_traits<char>, memory::SlabAllocator<char>>;
+using YList = std::vector<Value, memory::SlabAllocator<Value>>;
+using YFields = SlabKVStorage<Symbol, ManagedObject *>;
+using YMethods = SlabKVStorage<Symbol, ast::FunctionDef *>;
+
+
+// builtin types have fixed tags, every user type shares YType::User and is told apart by typename id
+enum class YType : uint8_t {
+    None,
+    Bool,
+    Int,
+    Float,
+    String,
+    List,
+    Dict,
+    User
+};
+
+
+// global registry of type names, ids of builtin types are equal to their YType
+uint32_t typename_id(const std::string &type_name);
+const std::string &typename_by_id(uint32_t id);
+
+
+// payload of primitive types lives inline, other types keep pointer to heap value
+union YPayload {
+    ssize_t int_;
+    double float_;
+    bool bool_;
+    void *ptr_;
+};
 
 
-//TODO hierarchy?? enum?? let think (lp)
 class YObject {
-    std::string typename_;
-    KVStorage<std::string, ManagedObject *> *fields_;
-    KVStorage<std::string, ast::FunctionDef *> *methods_;
-    void *___yapvm_objval_; // reinterpret_cast for usage, yes yes very bad gcc-style type erasure
+    YType type_;
+    uint32_t typename_id_;
+    YPayload payload_;
+    YFields *fields_;
+    YMethods *methods_;
 
-    YObject(std::string type_name, void *value, KVStorage<std::string, ManagedObject *> *fields, KVStorage<std::string, ast::FunctionDef *> *methods);
+    YObject(YType type, uint32_t typename_id, YPayload payload, YFields *fields, YMethods *methods);
 
 public:
     YObject(std::string type_name);
-    YObject(std::string type_name, void *value);
+    YObject(YType type, void *value = nullptr); // for types with heap payload, allocated by memory::slab_new
+    explicit YObject(ssize_t value);
+    explicit YObject(double value);
+    explicit YObject(bool value);
+
+    YObject(YObject &&other) noexcept;
+    YObject &operator=(YObject &&other) noexcept;
+    YObject(const YObject &) = delete;
+    YObject &operator=(const YObject &) = delete;
 
     ~YObject();
 
     YObject steal_personality() noexcept;
 
-    const std::string &get_typename() const { return typename_; }
+    YType get_type() const { return type_; }
+
+    uint32_t get_typename_id() const { return typename_id_; }
+
+    // only for error messages and user types, use get_type() for checks
+    const std::string &get_typename() const { return typename_by_id(typename_id_); }
 
-    void add_field(std::string name, ManagedObject *field);
+    void add_field(Symbol name, ManagedObject *field);
 
-    void add_method(std::string name, yapvm::ast::FunctionDef *method);
+    void add_method(Symbol name, yapvm::ast::FunctionDef *method);
 
-    ManagedObject *get_field(const std::string &name);
+    ManagedObject *get_field(Symbol name);
 
-    ast::FunctionDef *get_method(const std::string &name);
+    ast::FunctionDef *get_method(Symbol name);
 
-    std::vector<std::string *> get_methods_names() const;
+    std::vector<Symbol *> get_methods_names() const;
 
-    std::vector<std::string *> get_fields_names() const;
+    std::vector<Symbol *> get_fields_names() const;
 
     std::vector<ManagedObject *> get_fields();
 
+    std::vector<ManagedObject **> get_field_slots();
+
+    // for int, float and bool points to inline payload
     void *get____yapvm_objval_() const;
 
     void set____yapvm_objval_(void *value);
 
-    bool get_value_as_bool() const;
+    bool get_value_as_bool() const { return payload_.bool_; }
 
     std::string get_value_as_string() const;
 
-    const std::vector<ManagedObject *> &get_value_as_list() const;
+    const YList &get_value_as_list() const;
 
-    double get_value_as_float() const;
+    double get_value_as_float() const { return payload_.float_; }
 
-    ssize_t get_value_as_int() const;
+    ssize_t get_value_as_int() const { return payload_.int_; }
 
-    void set_value_as_bool(bool value) const;
+    void set_value_as_bool(bool value);
 
     void set_value_as_string(std::string value) const;
 
-    void set_value_as_float(double value) const;
+    void set_value_as_float(double value);
 
-    void set_value_as_int(ssize_t value) const;
+    void set_value_as_int(ssize_t value);
 
-    void set_value_as_list(std::vector<ManagedObject *> vec) const;
+    void set_value_as_list(YList vec) const;
 
-    ManagedObject *get_list_element(size_t idx) const;
+    Value get_list_element(size_t idx) const;
 
-    void set_list_element(size_t idx, ManagedObject *obj) const;
+    void set_list_element(size_t idx, Value obj) const;
 
-    void add_list_element(ManagedObject *obj) const;
+    void add_list_element(Value obj) const;
 
     size_t get_len_as_list() const;
 };
@@ -108,32 +178,154 @@ YObject *constr_ystring(std::string value);
 YObject *constr_ybool(bool value);
 YObject *constr_ynone();
 YObject *constr_ylist();
-YObject *constr_ylist(std::vector<ManagedObject *> *);
+YObject *constr_ylist(std::vector<ManagedObject *> *); // elements are copied, vector stays owned by caller
+YObject *constr_ylist(YList *); // list should be allocated by memory::slab_new
 YObject *constr_ydict();
 //TODO
 
-// work with collections
+// work with collections, only heap elements are returned
 bool is_collection(YObject *); 
 std::vector<ManagedObject *> get_list_elements(YObject *);
 std::vector<ManagedObject *> get_dict_elements(YObject *);
 std::vector<ManagedObject *> get_collection_elements(YObject *);
 
+// untracked objects (constants, objects not registered in gc yet) are never moved or freed by minor gc
+enum class Generation : uint8_t {
+    Untracked,
+    Young,
+    Old
+};
+
+
 class ManagedObject {
-    YObject value_;
-    bool marked_;
+    YObject value_; // mark bit is kept in bitmap of chunk, see memory::Chunk::marks_
+    Generation generation_{ Generation::Untracked };
+    std::atomic_bool remembered_{ false };
+    std::atomic_flag lock_; // payload of object is scanned by concurrent marker under it
+    ManagedObject *forward_{ nullptr }; // set when young object was copied to old generation
+
+    void write_barrier(ManagedObject *ref) {
+        if (generation_ == Generation::Old && ref != nullptr && ref->generation_ != Generation::Old
+            && !remembered_.exchange(true)) {
+            remember(this);
+        }
+    }
 
 public:
     ManagedObject(YObject *value);
+    ManagedObject(YObject &&value);
+
+    // allocated in TLAB of current thread, see memory::current_allocator
+    static void *operator new(size_t size);
+    static void operator delete(void *data);
 
-    YObject *value();
+    YObject *value() { return &value_; }
     bool is_marked() const;
 
     void mark();
     void unmark();
+    bool try_mark(); // true if object was not marked before, safe for concurrent markers
     void set_value(YObject *value);
+
+    Generation generation() const { return generation_; }
+    void set_generation(Generation generation) { generation_ = generation; }
+    ManagedObject *forward() const { return forward_; }
+    void set_forward(ManagedObject *to) { forward_ = to; }
+    void forget() { remembered_ = false; }
+
+    void lock() {
+        while (lock_.test_and_set(std::memory_order_acquire)) {
+            lock_.wait(true, std::memory_order_relaxed);
+        }
+    }
+
+    void unlock() {
+        lock_.clear(std::memory_order_release);
+        lock_.notify_one();
+    }
+
+    // mutators of managed objects, old objects storing young references get to remembered set
+    // while concurrent mark is active they lock object and log overwritten references, see satb_enqueue
+    void set_list_element(size_t idx, Value obj);
+    void add_list_element(Value obj);
+    void add_field(Symbol name, ManagedObject *field);
+
+    // gc helper, calls on_value for list elements and on_ref for fields, dict entries are not visited
+    template <typename ValueVisitor, typename RefVisitor>
+    void visit_slots(ValueVisitor &&on_value, RefVisitor &&on_ref);
 };
 
 
+// single allocation for primitives, payload is stored inline in ManagedObject
+ManagedObject *managed_yint(ssize_t value);
+ManagedObject *managed_yfloat(double value);
+ManagedObject *managed_ybool(bool value);
+
+
+// content of variable, list element or operand stack slot
+// int, float, bool and None are immediates and never reach gc, other types are references to ManagedObject
+// heap primitives are still accepted as references, accessors work with both
+class Value {
+    bool is_object_;
+    YType type_; // type of immediate, for references it is read from object
+    union {
+        ssize_t int_;
+        double float_;
+        bool bool_;
+        ManagedObject *object_;
+    };
+
+    Value(YType type) : is_object_{ false }, type_{ type }, int_{ 0 } {}
+
+public:
+    Value() : is_object_{ true }, type_{ YType::None }, object_{ nullptr } {}
+    Value(ManagedObject *object) : is_object_{ true }, type_{ YType::None }, object_{ object } {}
+
+    static Value none() { return Value{ YType::None }; }
+    static Value from_int(ssize_t value) { Value v{ YType::Int }; v.int_ = value; return v; }
+    static Value from_float(double value) { Value v{ YType::Float }; v.float_ = value; return v; }
+    static Value from_bool(bool value) { Value v{ YType::Bool }; v.bool_ = value; return v; }
+
+    bool is_object() const { return is_object_; }
+
+    // nullptr for immediates
+    ManagedObject *object() const { return is_object_ ? object_ : nullptr; }
+
+    // only for references
+    YObject *yobject() const { return object_->value(); }
+
+    YType get_type() const { return is_object_ ? object_->value()->get_type() : type_; }
+
+    uint32_t get_typename_id() const {
+        return is_object_ ? object_->value()->get_typename_id() : static_cast<uint32_t>(type_);
+    }
+
+    const std::string &get_typename() const { return typename_by_id(get_typename_id()); }
+
+    bool get_value_as_bool() const { return is_object_ ? object_->value()->get_value_as_bool() : bool_; }
+
+    ssize_t get_value_as_int() const { return is_object_ ? object_->value()->get_value_as_int() : int_; }
+
+    double get_value_as_float() const { return is_object_ ? object_->value()->get_value_as_float() : float_; }
+
+    // identity, immediates are identical if they have same type and value
+    bool operator==(const Value &other) const;
+};
+
+
+template <typename ValueVisitor, typename RefVisitor>
+void ManagedObject::visit_slots(ValueVisitor &&on_value, RefVisitor &&on_ref) {
+    if (value_.get_type() == YType::List) {
+        for (Value &v : *static_cast<YList *>(value_.get____yapvm_objval_())) {
+            on_value(v);
+        }
+    }
+    for (ManagedObject **field : value_.get_field_slots()) {
+        on_ref(*field);
+    }
+}
+
+
 size_t managed_yobject_hash(ManagedObject *o);
 
 
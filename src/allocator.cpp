@@ -0,0 +1,816 @@
+#include "allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+
+using namespace yapvm::memory;
+
+
+static constexpr int64_t CHUNK_OWNER_BIAS = int64_t{ 1 } << 62;
+
+static constexpr size_t CHUNK_HEADER_SIZE = (sizeof(Chunk) + ALLOCATION_ALIGN - 1) & ~(ALLOCATION_ALIGN - 1);
+
+
+yapvm::memory::Allocator::Allocator() = default;
+
+
+yapvm::memory::Allocator::~Allocator() = default;
+
+
+yapvm::memory::Chunk::Chunk(Heap *heap) : heap_{ heap }, pending_{ CHUNK_OWNER_BIAS } {}
+
+
+char *yapvm::memory::Chunk::begin() {
+    return reinterpret_cast<char *>(this) + CHUNK_HEADER_SIZE;
+}
+
+
+char *yapvm::memory::Chunk::end() {
+    return reinterpret_cast<char *>(this) + CHUNK_SIZE;
+}
+
+
+Chunk *yapvm::memory::Chunk::of(const void *data) {
+    return reinterpret_cast<Chunk *>(reinterpret_cast<uintptr_t>(data) & ~(CHUNK_SIZE - 1));
+}
+
+
+size_t yapvm::memory::Chunk::granule(const void *data) {
+    return (reinterpret_cast<uintptr_t>(data) & (CHUNK_SIZE - 1)) / ALLOCATION_ALIGN;
+}
+
+
+bool yapvm::memory::Chunk::is_marked(const void *data) const {
+    size_t g = granule(data);
+    return (marks_[g / 64].load(std::memory_order_relaxed) >> (g % 64)) & 1;
+}
+
+
+void yapvm::memory::Chunk::set_marked(const void *data, bool marked) {
+    size_t g = granule(data);
+    uint64_t bit = uint64_t{ 1 } << (g % 64);
+    if (marked) {
+        marks_[g / 64].fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        marks_[g / 64].fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+
+bool yapvm::memory::Chunk::try_mark(const void *data) {
+    size_t g = granule(data);
+    uint64_t bit = uint64_t{ 1 } << (g % 64);
+    std::atomic_uint64_t &word = marks_[g / 64];
+    return (word.load(std::memory_order_relaxed) & bit) == 0 && (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+}
+
+
+yapvm::memory::OutOfMemory::OutOfMemory(size_t max_size)
+    : std::runtime_error("Allocator: out of memory, max heap size of " + std::to_string(max_size) + " bytes exceeded") {}
+
+
+yapvm::memory::Heap::Heap(size_t max_size) : max_size_{ max_size } {}
+
+
+yapvm::memory::Heap::~Heap() {
+    for (Chunk *chunk : pool_) {
+        std::free(chunk);
+    }
+}
+
+
+void yapvm::memory::Heap::commit(size_t num_bytes) {
+    size_t max_size = max_size_.load(std::memory_order_relaxed);
+    size_t before = committed_.load(std::memory_order_relaxed);
+    do {
+        if (before + num_bytes > max_size) {
+            throw OutOfMemory{ max_size };
+        }
+    } while (!committed_.compare_exchange_weak(before, before + num_bytes, std::memory_order_relaxed));
+    note_allocation(num_bytes);
+
+    // gc should free memory before allocations reach max size
+    size_t pressure = max_size / 4 * 3;
+    if (before < pressure && before + num_bytes >= pressure) {
+        request_gc();
+    }
+}
+
+
+void yapvm::memory::Heap::uncommit(size_t num_bytes) {
+    committed_.fetch_sub(num_bytes, std::memory_order_relaxed);
+    freed_.fetch_add(num_bytes, std::memory_order_relaxed);
+}
+
+
+Chunk *yapvm::memory::Heap::acquire_chunk() {
+    commit(CHUNK_SIZE);
+    void *memory = nullptr;
+    {
+        std::lock_guard lock{ monitor_ };
+        if (!pool_.empty()) {
+            memory = pool_.back();
+            pool_.pop_back();
+        }
+    }
+    if (memory == nullptr) {
+        memory = std::aligned_alloc(CHUNK_SIZE, CHUNK_SIZE);
+    }
+    if (memory == nullptr) {
+        uncommit(CHUNK_SIZE);
+        throw std::bad_alloc{};
+    }
+    return new (memory) Chunk{ this };
+}
+
+
+void yapvm::memory::Heap::release_chunk(Chunk *chunk) {
+    chunk->~Chunk();
+    uncommit(CHUNK_SIZE);
+    {
+        std::lock_guard lock{ monitor_ };
+        if ((pool_.size() + 1) * CHUNK_SIZE <= min_size_) {
+            pool_.push_back(chunk);
+            return;
+        }
+    }
+    std::free(chunk);
+}
+
+
+void yapvm::memory::Heap::set_max_size(size_t max_size) {
+    max_size_.store(max_size, std::memory_order_relaxed);
+}
+
+
+size_t yapvm::memory::Heap::max_size() {
+    return max_size_.load(std::memory_order_relaxed);
+}
+
+
+size_t yapvm::memory::Heap::committed() {
+    return committed_.load(std::memory_order_relaxed);
+}
+
+
+void yapvm::memory::Heap::reserve(size_t min_size) {
+    std::lock_guard lock{ monitor_ };
+    min_size_ = min_size;
+    while ((pool_.size() + 1) * CHUNK_SIZE <= min_size_) {
+        void *memory = std::aligned_alloc(CHUNK_SIZE, CHUNK_SIZE);
+        if (memory == nullptr) {
+            throw std::bad_alloc{};
+        }
+        std::memset(memory, 0, CHUNK_SIZE); // pages are faulted in now, not by first allocations
+        pool_.push_back(static_cast<Chunk *>(memory));
+    }
+}
+
+
+size_t yapvm::memory::Heap::reserved() {
+    std::lock_guard lock{ monitor_ };
+    return pool_.size() * CHUNK_SIZE;
+}
+
+
+void yapvm::memory::Heap::note_allocation(size_t num_bytes) {
+    size_t before = allocated_.fetch_add(num_bytes, std::memory_order_relaxed);
+    size_t trigger = gc_trigger_.load(std::memory_order_relaxed);
+    if (before < trigger && before + num_bytes >= trigger) {
+        wake_gc();
+    }
+}
+
+
+size_t yapvm::memory::Heap::take_allocated() {
+    return allocated_.exchange(0, std::memory_order_relaxed);
+}
+
+
+size_t yapvm::memory::Heap::take_freed() {
+    return freed_.exchange(0, std::memory_order_relaxed);
+}
+
+
+void yapvm::memory::Heap::set_gc_trigger(size_t num_bytes) {
+    gc_trigger_.store(num_bytes, std::memory_order_relaxed);
+}
+
+
+bool yapvm::memory::Heap::wait_for_gc_request(std::chrono::milliseconds timeout) {
+    std::unique_lock lock{ gc_monitor_ };
+    gc_request_.wait_for(lock, timeout, [this]() {
+        return gc_woken_ || gc_requested_
+            || allocated_.load(std::memory_order_relaxed) >= gc_trigger_.load(std::memory_order_relaxed);
+    });
+    bool requested = gc_requested_;
+    gc_woken_ = false;
+    gc_requested_ = false;
+    return requested || allocated_.load(std::memory_order_relaxed) >= gc_trigger_.load(std::memory_order_relaxed);
+}
+
+
+void yapvm::memory::Heap::request_gc() {
+    {
+        std::lock_guard lock{ gc_monitor_ };
+        gc_requested_ = true;
+    }
+    gc_request_.notify_one();
+}
+
+
+void yapvm::memory::Heap::wake_gc() {
+    {
+        std::lock_guard lock{ gc_monitor_ };
+        gc_woken_ = true;
+    }
+    gc_request_.notify_one();
+}
+
+
+Heap &yapvm::memory::Heap::instance() {
+    static Heap heap;
+    return heap;
+}
+
+
+yapvm::memory::TLAB::TLAB(Heap *heap) : heap_{ heap } {}
+
+
+yapvm::memory::TLAB::~TLAB() {
+    retire();
+}
+
+
+void yapvm::memory::TLAB::refill() {
+    retire();
+    chunk_ = heap_->acquire_chunk();
+    top_ = chunk_->begin();
+    end_ = chunk_->end();
+    allocated_ = 0;
+}
+
+
+void *yapvm::memory::TLAB::allocate(size_t num_bytes) {
+    num_bytes = (num_bytes + ALLOCATION_ALIGN - 1) & ~(ALLOCATION_ALIGN - 1);
+    if (static_cast<size_t>(end_ - top_) < num_bytes) {
+        if (num_bytes > CHUNK_SIZE - CHUNK_HEADER_SIZE) {
+            throw std::runtime_error("Allocator: object does not fit in chunk");
+        }
+        refill();
+    }
+    void *res = top_;
+    top_ += num_bytes;
+    allocated_++;
+    return res;
+}
+
+
+void yapvm::memory::TLAB::deallocate(void *data) {
+    release(data);
+}
+
+
+void yapvm::memory::TLAB::retire() {
+    if (chunk_ == nullptr) {
+        return;
+    }
+    Chunk *chunk = chunk_;
+    chunk_ = nullptr;
+    top_ = nullptr;
+    end_ = nullptr;
+
+    // owner bias is replaced by real number of allocations, whoever brings counter to zero releases chunk
+    int64_t delta = allocated_ - CHUNK_OWNER_BIAS;
+    if (chunk->pending_.fetch_add(delta) + delta == 0) {
+        heap_->release_chunk(chunk);
+    }
+}
+
+
+// allocated cells bitmap takes first granules of cell chunk, cells follow it
+static constexpr size_t CELL_BITMAP_SIZE = CHUNK_BITMAP_WORDS * sizeof(uint64_t);
+
+
+static uint64_t *cell_bitmap(Chunk *chunk) {
+    return reinterpret_cast<uint64_t *>(chunk->begin());
+}
+
+
+static char *first_cell(Chunk *chunk) {
+    return chunk->begin() + CELL_BITMAP_SIZE;
+}
+
+
+yapvm::memory::CellSpace::CellSpace(Heap *heap, size_t cell_size, void (*finalize)(void *))
+    : heap_{ heap }, cell_size_{ (cell_size + ALLOCATION_ALIGN - 1) & ~(ALLOCATION_ALIGN - 1) }, finalize_{ finalize } {}
+
+
+yapvm::memory::CellSpace::~CellSpace() {
+    // chunks with live objects are left to their users, as TLAB does
+    for (CellChunk &c : chunks_) {
+        uint64_t *bits = cell_bitmap(c.chunk_);
+        if (std::all_of(bits, bits + CHUNK_BITMAP_WORDS, [](uint64_t w) { return w == 0; })) {
+            heap_->release_chunk(c.chunk_);
+        } else {
+            c.chunk_->space_ = nullptr;
+        }
+    }
+}
+
+
+size_t yapvm::memory::CellSpace::sweep_chunk(CellChunk &c) {
+    uint64_t *bits = cell_bitmap(c.chunk_);
+    size_t dead_ctr = 0;
+    for (size_t w = 0; w < CHUNK_BITMAP_WORDS; w++) {
+        uint64_t marks = c.chunk_->marks_[w].load(std::memory_order_relaxed);
+        uint64_t dead = bits[w] & ~marks;
+        while (dead != 0) {
+            size_t bit = static_cast<size_t>(std::countr_zero(dead));
+            dead &= dead - 1;
+            finalize_(reinterpret_cast<char *>(c.chunk_) + (w * 64 + bit) * ALLOCATION_ALIGN);
+            dead_ctr++;
+        }
+        bits[w] &= marks;
+        c.chunk_->marks_[w].store(0, std::memory_order_relaxed);
+    }
+    c.swept_ = true;
+    live_ -= dead_ctr;
+    return dead_ctr;
+}
+
+
+void *yapvm::memory::CellSpace::allocate(size_t num_bytes) {
+    if (num_bytes > cell_size_) {
+        throw std::runtime_error("Allocator: object does not fit in cell");
+    }
+    size_t cells = cells_per_chunk();
+    while (true) {
+        for (; alloc_chunk_ < chunks_.size(); alloc_chunk_++, alloc_cell_ = 0) {
+            CellChunk &c = chunks_[alloc_chunk_];
+            if (c.evacuating_) {
+                continue;
+            }
+            if (!c.swept_) {
+                sweep_chunk(c);
+            }
+            uint64_t *bits = cell_bitmap(c.chunk_);
+            for (; alloc_cell_ < cells; alloc_cell_++) {
+                char *cell = first_cell(c.chunk_) + alloc_cell_ * cell_size_;
+                size_t g = Chunk::granule(cell);
+                if (((bits[g / 64] >> (g % 64)) & 1) == 0) {
+                    bits[g / 64] |= uint64_t{ 1 } << (g % 64);
+                    alloc_cell_++;
+                    live_++;
+                    return cell;
+                }
+            }
+        }
+        Chunk *chunk = heap_->acquire_chunk();
+        chunk->space_ = this;
+        std::fill(cell_bitmap(chunk), cell_bitmap(chunk) + CHUNK_BITMAP_WORDS, 0);
+        chunks_.push_back(CellChunk{ chunk, true });
+    }
+}
+
+
+void yapvm::memory::CellSpace::deallocate(void *data) {
+    size_t g = Chunk::granule(data);
+    cell_bitmap(Chunk::of(data))[g / 64] &= ~(uint64_t{ 1 } << (g % 64));
+    Chunk::of(data)->set_marked(data, false);
+    live_--;
+}
+
+
+void yapvm::memory::CellSpace::start_sweep() {
+    for (CellChunk &c : chunks_) {
+        c.swept_ = false;
+    }
+    alloc_chunk_ = 0;
+    alloc_cell_ = 0;
+}
+
+
+size_t yapvm::memory::CellSpace::finish_sweep() {
+    size_t dead_ctr = 0;
+    std::vector<CellChunk> used;
+    for (CellChunk &c : chunks_) {
+        if (!c.swept_) {
+            dead_ctr += sweep_chunk(c);
+        }
+        uint64_t *bits = cell_bitmap(c.chunk_);
+        if (std::all_of(bits, bits + CHUNK_BITMAP_WORDS, [](uint64_t w) { return w == 0; })) {
+            heap_->release_chunk(c.chunk_);
+        } else {
+            used.push_back(c);
+        }
+    }
+    chunks_.swap(used);
+    alloc_chunk_ = 0;
+    alloc_cell_ = 0;
+    return dead_ctr;
+}
+
+
+size_t yapvm::memory::CellSpace::cells_per_chunk() const {
+    return (CHUNK_SIZE - CHUNK_HEADER_SIZE - CELL_BITMAP_SIZE) / cell_size_;
+}
+
+
+static size_t allocated_cells(Chunk *chunk) {
+    uint64_t *bits = cell_bitmap(chunk);
+    size_t res = 0;
+    for (size_t w = 0; w < CHUNK_BITMAP_WORDS; w++) {
+        res += static_cast<size_t>(std::popcount(bits[w]));
+    }
+    return res;
+}
+
+
+std::vector<void *> yapvm::memory::CellSpace::start_evacuation(double max_occupancy) {
+    size_t cells = cells_per_chunk();
+    std::vector<std::pair<size_t, CellChunk *>> sparse; // allocated cells, chunk
+    size_t free_cells = 0;
+    for (CellChunk &c : chunks_) {
+        size_t allocated = allocated_cells(c.chunk_);
+        free_cells += cells - allocated;
+        if (static_cast<double>(allocated) <= max_occupancy * static_cast<double>(cells)) {
+            sparse.emplace_back(allocated, &c);
+        }
+    }
+    // sparsest chunks first, every chosen chunk adds its objects to move and takes its free cells away
+    std::sort(sparse.begin(), sparse.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    size_t moved = 0;
+    std::vector<void *> res;
+    for (auto &[allocated, c] : sparse) {
+        if (moved + allocated > free_cells - (cells - allocated)) {
+            break;
+        }
+        moved += allocated;
+        free_cells -= cells - allocated;
+        c->evacuating_ = true;
+        uint64_t *bits = cell_bitmap(c->chunk_);
+        for (size_t i = 0; i < cells; i++) {
+            char *cell = first_cell(c->chunk_) + i * cell_size_;
+            size_t g = Chunk::granule(cell);
+            if ((bits[g / 64] >> (g % 64)) & 1) {
+                res.push_back(cell);
+            }
+        }
+    }
+    alloc_chunk_ = 0;
+    alloc_cell_ = 0;
+    return res;
+}
+
+
+size_t yapvm::memory::CellSpace::finish_evacuation() {
+    size_t released = 0;
+    std::vector<CellChunk> used;
+    for (CellChunk &c : chunks_) {
+        if (c.evacuating_ && allocated_cells(c.chunk_) == 0) {
+            heap_->release_chunk(c.chunk_);
+            released++;
+            continue;
+        }
+        c.evacuating_ = false;
+        used.push_back(c);
+    }
+    chunks_.swap(used);
+    alloc_chunk_ = 0;
+    alloc_cell_ = 0;
+    return released;
+}
+
+
+double yapvm::memory::CellSpace::fragmentation() const {
+    if (chunks_.empty()) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(live_) / static_cast<double>(chunks_.size() * cells_per_chunk());
+}
+
+
+size_t yapvm::memory::CellSpace::live() const {
+    return live_;
+}
+
+
+size_t yapvm::memory::CellSpace::chunks() const {
+    return chunks_.size();
+}
+
+
+void yapvm::memory::release(void *data) {
+    if (data == nullptr) {
+        return;
+    }
+    Chunk *chunk = Chunk::of(data);
+    if (chunk->space_ != nullptr) {
+        chunk->space_->deallocate(data);
+        return;
+    }
+    if (chunk->pending_.fetch_sub(1) == 1) {
+        chunk->heap_->release_chunk(chunk);
+    }
+}
+
+
+static thread_local Allocator *installed_allocator = nullptr;
+
+
+Allocator *yapvm::memory::current_allocator() {
+    if (installed_allocator != nullptr) {
+        return installed_allocator;
+    }
+    static thread_local TLAB thread_tlab{ &Heap::instance() };
+    return &thread_tlab;
+}
+
+
+void yapvm::memory::set_current_allocator(Allocator *allocator) {
+    installed_allocator = allocator;
+}
+
+
+namespace {
+
+constexpr std::array<size_t, 28> SLAB_CLASSES = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096
+};
+
+static_assert(SLAB_CLASSES.back() == SLAB_MAX_BLOCK);
+
+
+// class index by (size + 15) / 16
+constexpr std::array<uint8_t, SLAB_MAX_BLOCK / 16 + 1> SLAB_CLASS_OF = [] {
+    std::array<uint8_t, SLAB_MAX_BLOCK / 16 + 1> res{};
+    uint8_t cls = 0;
+    for (size_t i = 0; i < res.size(); i++) {
+        while (SLAB_CLASSES[cls] < i * 16) {
+            cls++;
+        }
+        res[i] = cls;
+    }
+    return res;
+}();
+
+
+class SlabHeap;
+
+
+struct SlabBlock {
+    SlabBlock *next_;
+};
+
+
+// header in the beginning of every slab page, page holds blocks of one size class
+struct SlabPage {
+    std::atomic<SlabHeap *> owner_;
+    size_t cls_;
+    size_t block_size_;
+    SlabBlock *free_ = nullptr;                     // touched only by owner
+    std::atomic<SlabBlock *> thread_free_ = nullptr; // freed by other threads
+    size_t live_ = 0;                               // blocks not freed, owner counts blocks of thread_free_ when collects them
+    char *bump_;
+    char *end_;
+    SlabPage *next_ = nullptr;                      // next page of same class in owner heap
+    SlabPage *prev_ = nullptr;
+
+    SlabPage(SlabHeap *owner, size_t cls);
+
+    void *pop();
+    void collect_thread_free();
+
+    static SlabPage *of(void *data) {
+        return reinterpret_cast<SlabPage *>(reinterpret_cast<uintptr_t>(data) & ~(SLAB_PAGE_SIZE - 1));
+    }
+};
+
+
+constexpr size_t SLAB_PAGE_HEADER_SIZE = (sizeof(SlabPage) + ALLOCATION_ALIGN - 1) & ~(ALLOCATION_ALIGN - 1);
+
+
+// pages of finished threads, adopted by next thread which needs page of same class
+std::mutex abandoned_monitor;
+std::array<SlabPage *, SLAB_CLASSES.size()> abandoned{};
+
+
+class SlabHeap {
+    std::array<SlabPage *, SLAB_CLASSES.size()> current_{};
+    std::array<SlabPage *, SLAB_CLASSES.size()> pages_{};
+
+    void *allocate_slow(size_t cls);
+    void link(SlabPage *page);
+    void unlink(SlabPage *page);
+    // page without live blocks is given back to heap, so committed bytes follow live payloads
+    static void release(SlabPage *page);
+
+public:
+    SlabHeap() = default;
+    ~SlabHeap();
+
+    void *allocate(size_t cls) {
+        SlabPage *page = current_[cls];
+        if (page != nullptr) {
+            if (void *res = page->pop(); res != nullptr) {
+                return res;
+            }
+        }
+        return allocate_slow(cls);
+    }
+
+    void deallocate(void *data) {
+        SlabPage *page = SlabPage::of(data);
+        SlabBlock *block = static_cast<SlabBlock *>(data);
+        if (page->owner_.load(std::memory_order_relaxed) == this) {
+            block->next_ = page->free_;
+            page->free_ = block;
+            if (--page->live_ == 0 && page != current_[page->cls_]) {
+                unlink(page);
+                release(page);
+            }
+            return;
+        }
+        SlabBlock *head = page->thread_free_.load(std::memory_order_relaxed);
+        do {
+            block->next_ = head;
+        } while (!page->thread_free_.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static SlabHeap &local() {
+        static thread_local SlabHeap heap;
+        return heap;
+    }
+};
+
+
+SlabPage::SlabPage(SlabHeap *owner, size_t cls)
+    : owner_{ owner }, cls_{ cls }, block_size_{ SLAB_CLASSES[cls] },
+      bump_{ reinterpret_cast<char *>(this) + SLAB_PAGE_HEADER_SIZE }, end_{ reinterpret_cast<char *>(this) + SLAB_PAGE_SIZE } {}
+
+
+void *SlabPage::pop() {
+    if (free_ != nullptr) {
+        SlabBlock *res = free_;
+        free_ = res->next_;
+        live_++;
+        return res;
+    }
+    if (static_cast<size_t>(end_ - bump_) >= block_size_) {
+        void *res = bump_;
+        bump_ += block_size_;
+        live_++;
+        return res;
+    }
+    return nullptr;
+}
+
+
+void SlabPage::collect_thread_free() {
+    SlabBlock *list = thread_free_.exchange(nullptr, std::memory_order_acquire);
+    while (list != nullptr) {
+        SlabBlock *next = list->next_;
+        list->next_ = free_;
+        free_ = list;
+        list = next;
+        live_--;
+    }
+}
+
+
+void *SlabHeap::allocate_slow(size_t cls) {
+    // empty pages are released, except the first one with free blocks which becomes current
+    SlabPage *target = nullptr;
+    for (SlabPage *page = pages_[cls]; page != nullptr;) {
+        SlabPage *next = page->next_;
+        page->collect_thread_free();
+        if (target == nullptr && (page->free_ != nullptr || static_cast<size_t>(page->end_ - page->bump_) >= page->block_size_)) {
+            target = page;
+        } else if (page->live_ == 0) {
+            unlink(page);
+            release(page);
+        }
+        page = next;
+    }
+    if (target != nullptr) {
+        current_[cls] = target;
+        return target->pop();
+    }
+
+    SlabPage *page = nullptr;
+    {
+        std::lock_guard lock{ abandoned_monitor };
+        if (abandoned[cls] != nullptr) {
+            page = abandoned[cls];
+            abandoned[cls] = page->next_;
+            page->owner_.store(this, std::memory_order_relaxed);
+        }
+    }
+    if (page == nullptr) {
+        Heap::instance().commit(SLAB_PAGE_SIZE); // uncommitted by release, finished threads leave live pages to others
+        void *memory = std::aligned_alloc(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+        if (memory == nullptr) {
+            Heap::instance().uncommit(SLAB_PAGE_SIZE);
+            throw std::bad_alloc{};
+        }
+        page = new (memory) SlabPage{ this, cls };
+    }
+    page->collect_thread_free();
+    link(page);
+    current_[cls] = page;
+    return allocate(cls);
+}
+
+
+void SlabHeap::link(SlabPage *page) {
+    page->prev_ = nullptr;
+    page->next_ = pages_[page->cls_];
+    if (page->next_ != nullptr) {
+        page->next_->prev_ = page;
+    }
+    pages_[page->cls_] = page;
+}
+
+
+void SlabHeap::unlink(SlabPage *page) {
+    if (page->prev_ != nullptr) {
+        page->prev_->next_ = page->next_;
+    } else {
+        pages_[page->cls_] = page->next_;
+    }
+    if (page->next_ != nullptr) {
+        page->next_->prev_ = page->prev_;
+    }
+    if (current_[page->cls_] == page) {
+        current_[page->cls_] = nullptr;
+    }
+}
+
+
+void SlabHeap::release(SlabPage *page) {
+    page->~SlabPage();
+    std::free(page);
+    Heap::instance().uncommit(SLAB_PAGE_SIZE);
+}
+
+
+SlabHeap::~SlabHeap() {
+    std::lock_guard lock{ abandoned_monitor };
+    for (size_t cls = 0; cls < SLAB_CLASSES.size(); cls++) {
+        SlabPage *page = pages_[cls];
+        while (page != nullptr) {
+            SlabPage *next = page->next_;
+            page->collect_thread_free();
+            if (page->live_ == 0) {
+                release(page);
+            } else {
+                page->owner_.store(nullptr, std::memory_order_relaxed);
+                page->next_ = abandoned[cls];
+                abandoned[cls] = page;
+            }
+            page = next;
+        }
+    }
+    current_ = {};
+    pages_ = {};
+}
+
+} // namespace
+
+
+void *yapvm::memory::slab_allocate(size_t num_bytes) {
+    if (num_bytes > SLAB_MAX_BLOCK) {
+        Heap::instance().commit(num_bytes);
+        try {
+            return ::operator new(num_bytes);
+        } catch (...) {
+            Heap::instance().uncommit(num_bytes);
+            throw;
+        }
+    }
+    return SlabHeap::local().allocate(SLAB_CLASS_OF[(num_bytes + 15) / 16]);
+}
+
+
+void yapvm::memory::slab_deallocate(void *data, size_t num_bytes) {
+    if (data == nullptr) {
+        return;
+    }
+    if (num_bytes > SLAB_MAX_BLOCK) {
+        ::operator delete(data);
+        Heap::instance().uncommit(num_bytes);
+        return;
+    }
+    SlabHeap::local().deallocate(data);
+}
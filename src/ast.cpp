@@ -6,8 +6,38 @@ using namespace yapvm::ast;
 using namespace yapvm;
 
 
+bool yapvm::ast::is_cmp_op_kind(NodeKind kind) {
+    return kind >= NodeKind::Eq && kind <= NodeKind::NotIn;
+}
+
+
+bool yapvm::ast::is_unary_op_kind(NodeKind kind) {
+    return kind >= NodeKind::Invert && kind <= NodeKind::USub;
+}
+
+
+bool yapvm::ast::is_bin_op_kind(NodeKind kind) {
+    return kind >= NodeKind::Add && kind <= NodeKind::FloorDiv;
+}
+
+
+bool yapvm::ast::is_bool_op_kind(NodeKind kind) {
+    return kind == NodeKind::And || kind == NodeKind::Or;
+}
+
+
+bool yapvm::ast::is_expr_kind(NodeKind kind) {
+    return kind >= NodeKind::BoolOp && kind <= NodeKind::Dict;
+}
+
+
+bool yapvm::ast::is_stmt_kind(NodeKind kind) {
+    return kind >= NodeKind::Import && kind <= NodeKind::Continue;
+}
+
+
 yapvm::ast::BoolOp::BoolOp(scoped_ptr<BoolOpKind> &&op, std::vector<scoped_ptr<Expr>> &&values)
-    : op_{ std::move(op) }, values_{ std::move(values) } {}
+    : Expr{ NodeKind::BoolOp }, op_{ std::move(op) }, values_{ std::move(values) } {}
 
 
 const scoped_ptr<BoolOpKind> &yapvm::ast::BoolOp::op() const {
@@ -21,7 +51,7 @@ const std::vector<scoped_ptr<Expr>> &yapvm::ast::BoolOp::values() const {
 
 
 yapvm::ast::BinOp::BinOp(scoped_ptr<Expr> &&left, scoped_ptr<BinOpKind> &&op, scoped_ptr<Expr> &&right)
-    : left_{ std::move(left) }, op_{ std::move(op) }, right_{ std::move(right) } {
+    : Expr{ NodeKind::BinOp }, left_{ std::move(left) }, op_{ std::move(op) }, right_{ std::move(right) } {
 }
 
 
@@ -41,7 +71,7 @@ const scoped_ptr<Expr> &yapvm::ast::BinOp::right() const {
 
 
 yapvm::ast::UnaryOp::UnaryOp(scoped_ptr<UnaryOpKind> &&op, scoped_ptr<Expr> &&operand)
-    : op_{ std::move(op) }, operand_{ std::move(operand) } {
+    : Expr{ NodeKind::UnaryOp }, op_{ std::move(op) }, operand_{ std::move(operand) } {
 }
 
 
@@ -56,7 +86,7 @@ const scoped_ptr<Expr> &yapvm::ast::UnaryOp::operand() const {
 
 
 yapvm::ast::Compare::Compare(scoped_ptr<Expr> &&left, std::vector<scoped_ptr<CmpOpKind>> &&ops, std::vector<scoped_ptr<Expr>> &&comparators)
-    : left_{ std::move(left) }, ops_{ std::move(ops) }, comparators_{ std::move(comparators) } {
+    : Expr{ NodeKind::Compare }, left_{ std::move(left) }, ops_{ std::move(ops) }, comparators_{ std::move(comparators) } {
 }
 
 
@@ -76,7 +106,7 @@ const std::vector<scoped_ptr<Expr>> &yapvm::ast::Compare::comparators() const {
 
 
 yapvm::ast::Call::Call(scoped_ptr<Expr> &&func, std::vector<scoped_ptr<Expr>> &&args)
-    : func_{ std::move(func) }, args_{ std::move(args) } {
+    : Expr{ NodeKind::Call }, func_{ std::move(func) }, args_{ std::move(args) } {
 }
 
 
@@ -90,7 +120,7 @@ const std::vector<scoped_ptr<Expr>> &yapvm::ast::Call::args() const {
 }
 
 
-yapvm::ast::Constant::Constant(scoped_ptr<yobjects::YObject> &&value) : value_{std::move(value)} {}
+yapvm::ast::Constant::Constant(scoped_ptr<yobjects::YObject> &&value) : Expr{ NodeKind::Constant }, value_{std::move(value)} {}
 
 
 const scoped_ptr<yobjects::YObject> &yapvm::ast::Constant::value() const {
@@ -98,7 +128,7 @@ const scoped_ptr<yobjects::YObject> &yapvm::ast::Constant::value() const {
 }
 
 yapvm::ast::Attribute::Attribute(scoped_ptr<Expr> &&value, std::string &&attr, scoped_ptr<ExprContext> &&ctx)
-    : value_{ std::move(value) }, attr_{ std::move(attr) }, ctx_{ std::move(ctx) } {
+    : Expr{ NodeKind::Attribute }, value_{ std::move(value) }, attr_{ attr }, ctx_{ std::move(ctx) } {
 }
 
 
@@ -112,13 +142,13 @@ const scoped_ptr<Expr> &yapvm::ast::Attribute::value() const {
 }
 
 
-const std::string &yapvm::ast::Attribute::attr() const {
+yapvm::Symbol yapvm::ast::Attribute::attr() const {
     return attr_;
 }
 
 
 yapvm::ast::Subscript::Subscript(scoped_ptr<Expr> &&value, scoped_ptr<Expr> &&key, scoped_ptr<ExprContext> &&ctx)
-    : value_{ std::move(value) }, key_{ std::move(key) }, ctx_{ std::move(ctx) } {
+    : Expr{ NodeKind::Subscript }, value_{ std::move(value) }, key_{ std::move(key) }, ctx_{ std::move(ctx) } {
 }
 
 
@@ -138,7 +168,7 @@ scoped_ptr<Expr> &yapvm::ast::Subscript::value() const {
 
 
 yapvm::ast::Name::Name(std::string &&id, scoped_ptr<ExprContext> &&ctx)
-    : id_{ std::move(id) }, ctx_{ std::move(ctx) } {
+    : Expr{ NodeKind::Name }, id_{ id }, ctx_{ std::move(ctx) } {
 }
 
 
@@ -147,18 +177,18 @@ const scoped_ptr<ExprContext> &yapvm::ast::Name::ctx() const {
 }
 
 
-const std::string &yapvm::ast::Name::id() const {
+yapvm::Symbol yapvm::ast::Name::id() const {
     return id_;
 }
 
 
 yapvm::ast::FunctionDef::FunctionDef(std::string &&name, std::vector<std::string> &&args, std::vector<scoped_ptr<Stmt>> &&body) 
-    : name_{ std::move(name) }, args_{ std::move(args) }, body_{ std::move(body) }, returns_{ nullptr } {
+    : Stmt{ NodeKind::FunctionDef }, name_{ std::move(name) }, args_{ args.begin(), args.end() }, body_{ std::move(body) }, returns_{ nullptr } {
 }
 
 
 yapvm::ast::FunctionDef::FunctionDef(std::string &&name, std::vector<std::string> &&args, std::vector<scoped_ptr<Stmt>> &&body, scoped_ptr<Expr> &&returns)
-    : name_{ std::move(name) }, args_{ std::move(args) }, body_{ std::move(body) }, returns_{ std::move(returns) } {}
+    : Stmt{ NodeKind::FunctionDef }, name_{ std::move(name) }, args_{ args.begin(), args.end() }, body_{ std::move(body) }, returns_{ std::move(returns) } {}
 
 
 const std::string &yapvm::ast::FunctionDef::name() const {
@@ -166,7 +196,7 @@ const std::string &yapvm::ast::FunctionDef::name() const {
 }
 
 
-const std::vector<std::string> &yapvm::ast::FunctionDef::args() const {
+const std::vector<yapvm::Symbol> &yapvm::ast::FunctionDef::args() const {
     return args_;
 }
 
@@ -187,7 +217,7 @@ const scoped_ptr<Expr> &yapvm::ast::FunctionDef::returns() const {
 
 
 yapvm::ast::ClassDef::ClassDef(std::string &&name, std::vector<scoped_ptr<Stmt>> &&body)
-    : name_{ std::move(name) }, body_{ std::move(body) } {}
+    : Stmt{ NodeKind::ClassDef }, name_{ std::move(name) }, body_{ std::move(body) } {}
 
 
 const std::string &yapvm::ast::ClassDef::name() const {
@@ -200,10 +230,10 @@ const std::vector<scoped_ptr<Stmt>> &yapvm::ast::ClassDef::body() const {
 }
 
 yapvm::ast::Return::Return(scoped_ptr<Expr> &&value)
-    : value_{ std::move(value) } {}
+    : Stmt{ NodeKind::Return }, value_{ std::move(value) } {}
 
 
-yapvm::ast::Return::Return() : value_{ nullptr } {}
+yapvm::ast::Return::Return() : Stmt{ NodeKind::Return }, value_{ nullptr } {}
 
 
 bool yapvm::ast::Return::returns_anything() const {
@@ -217,7 +247,7 @@ const scoped_ptr<Expr> &yapvm::ast::Return::value() const {
 
 
 yapvm::ast::Assign::Assign(std::vector<scoped_ptr<Expr>> &&target, scoped_ptr<Expr> &&value)
-    : target_{ std::move(target) }, value_{ std::move(value) } {
+    : Stmt{ NodeKind::Assign }, target_{ std::move(target) }, value_{ std::move(value) } {
 }
 
 
@@ -232,7 +262,7 @@ const scoped_ptr<Expr> &yapvm::ast::Assign::value() const {
 
 
 yapvm::ast::AugAssign::AugAssign(scoped_ptr<Expr> &&target, scoped_ptr<BinOpKind> &&op, scoped_ptr<Expr> &&value)
-    : target_{ std::move(target) }, op_{ std::move(op) }, value_{ std::move(value) } {
+    : Stmt{ NodeKind::AugAssign }, target_{ std::move(target) }, op_{ std::move(op) }, value_{ std::move(value) } {
 }
 
 
@@ -252,7 +282,7 @@ const scoped_ptr<Expr> &yapvm::ast::AugAssign::value() const {
 
 
 yapvm::ast::While::While(scoped_ptr<Expr> &&test, std::vector<scoped_ptr<Stmt>> &&body)
-    : test_{ std::move(test) }, body_{ std::move(body) } {
+    : Stmt{ NodeKind::While }, test_{ std::move(test) }, body_{ std::move(body) } {
 }
 
 
@@ -267,7 +297,7 @@ const std::vector<scoped_ptr<Stmt>> &yapvm::ast::While::body() const {
 
 
 yapvm::ast::If::If(scoped_ptr<Expr> &&test, std::vector<scoped_ptr<Stmt>> &&body, std::vector<scoped_ptr<Stmt>> &&orelse)
-    : test_{ std::move(test) }, body_{ std::move(body) }, orelse_{ std::move(orelse) } {
+    : Stmt{ NodeKind::If }, test_{ std::move(test) }, body_{ std::move(body) }, orelse_{ std::move(orelse) } {
 }
 
 
@@ -287,7 +317,7 @@ const std::vector<scoped_ptr<Stmt>> &yapvm::ast::If::orelse() const {
 
 
 yapvm::ast::ExprStmt::ExprStmt(scoped_ptr<Expr> &&value)
-    : value_{ std::move(value) } {
+    : Stmt{ NodeKind::ExprStmt }, value_{ std::move(value) } {
 }
 
 
@@ -296,7 +326,7 @@ const scoped_ptr<Expr> &yapvm::ast::ExprStmt::value() const {
 }
 
 
-yapvm::ast::Module::Module(std::vector<scoped_ptr<Stmt>> &&body) : body_{std::move(body)} {}
+yapvm::ast::Module::Module(std::vector<scoped_ptr<Stmt>> &&body) : Node{ NodeKind::Module }, body_{std::move(body)} {}
 
 
 const std::vector<scoped_ptr<Stmt>> &yapvm::ast::Module::body() const { return body_; }
@@ -307,7 +337,7 @@ std::vector<scoped_ptr<Stmt>> &&Module::steal_body() {
 }
 
 
-yapvm::ast::Import::Import(std::string &&name) : name_{ std::move(name) }{}
+yapvm::ast::Import::Import(std::string &&name) : Stmt{ NodeKind::Import }, name_{ std::move(name) }{}
 
 
 const std::string &yapvm::ast::Import::name() const {
@@ -316,7 +346,7 @@ const std::string &yapvm::ast::Import::name() const {
 
 
 yapvm::ast::For::For(scoped_ptr<Expr> &&target, scoped_ptr<Expr> &&iter, std::vector<scoped_ptr<Stmt>> &&body) 
-    : target_{ std::move(target) }, iter_{ std::move(iter) }, body_{ std::move(body) } {
+    : Stmt{ NodeKind::For }, target_{ std::move(target) }, iter_{ std::move(iter) }, body_{ std::move(body) } {
 }
 
 
@@ -336,12 +366,12 @@ const std::vector<scoped_ptr<Stmt>> &yapvm::ast::For::body() const {
 
 
 yapvm::ast::WithItem::WithItem(scoped_ptr<Expr> &&context_expr)
-    : context_expr_{ std::move(context_expr) }, optional_vars_{ nullptr } {
+    : Node{ NodeKind::WithItem }, context_expr_{ std::move(context_expr) }, optional_vars_{ nullptr } {
 }
 
 
 yapvm::ast::WithItem::WithItem(scoped_ptr<Expr> &&context_expr, scoped_ptr<Expr> &&optional_vars)
-    : context_expr_{ std::move(context_expr) }, optional_vars_{ std::move(optional_vars) } {
+    : Node{ NodeKind::WithItem }, context_expr_{ std::move(context_expr) }, optional_vars_{ std::move(optional_vars) } {
 }
 
 
@@ -361,7 +391,7 @@ bool yapvm::ast::WithItem::is_optional_var() const {
 
 
 yapvm::ast::With::With(std::vector<scoped_ptr<WithItem>> &&items, std::vector<scoped_ptr<Stmt>> &&body)
-    : items_{ std::move(items) }, body_{ std::move(body) } {}
+    : Stmt{ NodeKind::With }, items_{ std::move(items) }, body_{ std::move(body) } {}
 
 
 const std::vector<scoped_ptr<WithItem>> &yapvm::ast::With::items() const {
@@ -371,4 +401,4 @@ const std::vector<scoped_ptr<WithItem>> &yapvm::ast::With::items() const {
 
 const std::vector<scoped_ptr<Stmt>> &yapvm::ast::With::body() const {
     return body_;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "bytecode.h"
+
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+
+using namespace yapvm::bytecode;
+using namespace yapvm;
+
+
+yapvm::bytecode::CodeObject::CodeObject(std::string name, const ast::FunctionDef *def)
+    : name_{ std::move(name) }, def_{ def } {}
+
+
+yapvm::bytecode::CodeObject::~CodeObject() {
+    for (const Value &c : consts_) {
+        delete c.object();
+    }
+}
+
+
+void yapvm::bytecode::CodeObject::init_call_caches() {
+    call_caches_ = std::make_unique<CallCache[]>(call_sites_.size());
+}
+
+
+ast::FunctionDef *yapvm::bytecode::CallCache::find(uint64_t scope, uint64_t epoch, bool &polymorphic) const {
+    uint32_t used = std::min(used_.load(std::memory_order_acquire), WAYS);
+    for (uint32_t i = 0; i < used; i++) {
+        const CallCacheEntry &entry = entries_[i];
+        uint32_t version = entry.version_.load(std::memory_order_acquire);
+        if (version & 1) {
+            continue;
+        }
+        uint64_t entry_scope = entry.scope_.load(std::memory_order_relaxed);
+        ast::FunctionDef *callee = entry.callee_.load(std::memory_order_relaxed);
+        uint64_t entry_epoch = entry.epoch_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.version_.load(std::memory_order_relaxed) != version) {
+            continue;
+        }
+        if (entry_scope == scope && entry_epoch == epoch) {
+            polymorphic = used > 1;
+            return callee;
+        }
+    }
+    return nullptr;
+}
+
+
+void yapvm::bytecode::CallCache::insert(uint64_t scope, ast::FunctionDef *callee, uint64_t epoch) {
+    uint32_t used = std::min(used_.load(std::memory_order_acquire), WAYS);
+    uint32_t way = used;
+    for (uint32_t i = 0; i < used; i++) {
+        if (entries_[i].scope_.load(std::memory_order_relaxed) == scope) {
+            way = i;
+            break;
+        }
+    }
+    if (way == used && (used == WAYS || !used_.compare_exchange_strong(used, used + 1))) {
+        // someone else took the way, used_ is not zero anymore
+        way = victim_.fetch_add(1, std::memory_order_relaxed) % std::min(used_.load(), WAYS);
+    }
+
+    // entry being written by other thread is left to it
+    CallCacheEntry &entry = entries_[way];
+    uint32_t version = entry.version_.load(std::memory_order_relaxed);
+    if ((version & 1) || !entry.version_.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.scope_.store(scope, std::memory_order_relaxed);
+    entry.callee_.store(callee, std::memory_order_relaxed);
+    entry.epoch_.store(epoch, std::memory_order_relaxed);
+    entry.version_.store(version + 2, std::memory_order_release);
+}
+
+
+CallCacheStats &yapvm::bytecode::CallCacheStats::operator+=(const CallCacheStats &other) {
+    monomorphic_ += other.monomorphic_;
+    polymorphic_ += other.polymorphic_;
+    misses_ += other.misses_;
+    return *this;
+}
+
+
+std::string yapvm::bytecode::CallCacheStats::summary() const {
+    uint64_t calls = monomorphic_ + polymorphic_ + misses_;
+    auto percent = [calls](uint64_t n) { return calls == 0 ? 0.0 : 100.0 * static_cast<double>(n) / static_cast<double>(calls); };
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << calls << " calls, monomorphic hits " << percent(monomorphic_)
+        << "%, polymorphic hits " << percent(polymorphic_) << "%, misses " << percent(misses_) << "%";
+    return out.str();
+}
+
+
+static std::mutex call_cache_stats_mutex;
+static CallCacheStats total_call_cache_stats;
+
+
+void yapvm::bytecode::add_call_cache_stats(const CallCacheStats &stats) {
+    std::lock_guard lock{ call_cache_stats_mutex };
+    total_call_cache_stats += stats;
+}
+
+
+CallCacheStats yapvm::bytecode::call_cache_stats() {
+    std::lock_guard lock{ call_cache_stats_mutex };
+    return total_call_cache_stats;
+}
+
+
+yapvm::bytecode::Program::Program(scoped_ptr<CodeObject> &&module)
+    : module_{ std::move(module) } {}
+
+
+void yapvm::bytecode::Program::add_function(scoped_ptr<CodeObject> &&function) {
+    assert(function->def_ != nullptr);
+    by_def_[function->def_] = function.get();
+    functions_.emplace_back(std::move(function));
+}
+
+
+const CodeObject *yapvm::bytecode::Program::module() const {
+    return module_.get();
+}
+
+
+const CodeObject *yapvm::bytecode::Program::function_code(const ast::FunctionDef *def) const {
+    auto it = by_def_.find(def);
+    if (it == by_def_.end()) {
+        throw std::runtime_error("Program: function " + def->name() + " was not compiled");
+    }
+    return it->second;
+}
+
+
+BinaryOperator yapvm::bytecode::binary_operator(const ast::BinOpKind *op) {
+    switch (op->kind()) {
+        case ast::NodeKind::Add: return BINARY_ADD;
+        case ast::NodeKind::Sub: return BINARY_SUB;
+        case ast::NodeKind::Mult: return BINARY_MULT;
+        case ast::NodeKind::Div: return BINARY_DIV;
+        case ast::NodeKind::Mod: return BINARY_MOD;
+        case ast::NodeKind::Pow: return BINARY_POW;
+        case ast::NodeKind::LShift: return BINARY_LSHIFT;
+        case ast::NodeKind::RShift: return BINARY_RSHIFT;
+        case ast::NodeKind::BitOr: return BINARY_BITOR;
+        case ast::NodeKind::BitXor: return BINARY_BITXOR;
+        case ast::NodeKind::BitAnd: return BINARY_BITAND;
+        case ast::NodeKind::FloorDiv: return BINARY_FLOORDIV;
+        default: break;
+    }
+    throw std::runtime_error("Bytecode: unexpected BinaryOperatorKind");
+}
+
+
+UnaryOperator yapvm::bytecode::unary_operator(const ast::UnaryOpKind *op) {
+    switch (op->kind()) {
+        case ast::NodeKind::Invert: return UNARY_INVERT;
+        case ast::NodeKind::Not: return UNARY_NOT;
+        case ast::NodeKind::USub: return UNARY_USUB;
+        default: break;
+    }
+    throw std::runtime_error("Bytecode: unexpected UnaryOpKind");
+}
+
+
+CompareOperator yapvm::bytecode::compare_operator(const ast::CmpOpKind *op) {
+    switch (op->kind()) {
+        case ast::NodeKind::Eq: return CMP_EQ;
+        case ast::NodeKind::NotEq: return CMP_NOTEQ;
+        case ast::NodeKind::Lt: return CMP_LT;
+        case ast::NodeKind::LtE: return CMP_LTE;
+        case ast::NodeKind::Gt: return CMP_GT;
+        case ast::NodeKind::GtE: return CMP_GTE;
+        case ast::NodeKind::Is: return CMP_IS;
+        case ast::NodeKind::IsNot: return CMP_ISNOT;
+        case ast::NodeKind::In: return CMP_IN;
+        case ast::NodeKind::NotIn: return CMP_NOTIN;
+        default: break;
+    }
+    throw std::runtime_error("Bytecode: unexpected CmpOpKind");
+}
+
+
+const char *yapvm::bytecode::opcode_name(OpCode op) {
+    switch (op) {
+        case OP_NOP: return "NOP";
+        case OP_SAFEPOINT: return "SAFEPOINT";
+        case OP_LOAD_CONST: return "LOAD_CONST";
+        case OP_LOAD_NAME: return "LOAD_NAME";
+        case OP_LOAD_FAST: return "LOAD_FAST";
+        case OP_STORE_FAST: return "STORE_FAST";
+        case OP_POP: return "POP";
+        case OP_BINARY: return "BINARY";
+        case OP_UNARY: return "UNARY";
+        case OP_COMPARE: return "COMPARE";
+        case OP_BOOL_AND: return "BOOL_AND";
+        case OP_BOOL_OR: return "BOOL_OR";
+        case OP_JUMP: return "JUMP";
+        case OP_POP_JUMP_IF_FALSE: return "POP_JUMP_IF_FALSE";
+        case OP_LOAD_SUBSCR: return "LOAD_SUBSCR";
+        case OP_STORE_SUBSCR: return "STORE_SUBSCR";
+        case OP_LIST_APPEND: return "LIST_APPEND";
+        case OP_INPLACE_ADD: return "INPLACE_ADD";
+        case OP_BUILD_LIST: return "BUILD_LIST";
+        case OP_PRINT: return "PRINT";
+        case OP_CONVERT: return "CONVERT";
+        case OP_MAKE_FUNCTION: return "MAKE_FUNCTION";
+        case OP_CALL: return "CALL";
+        case OP_THREAD_SPAWN: return "THREAD_SPAWN";
+        case OP_THREAD_JOIN: return "THREAD_JOIN";
+        case OP_RETURN_VALUE: return "RETURN_VALUE";
+        case OP_RETURN_NONE: return "RETURN_NONE";
+        case OP_RAISE: return "RAISE";
+    }
+    return "UNKNOWN";
+}
+
+
+std::string yapvm::bytecode::disassemble(const CodeObject &code) {
+    std::stringstream out;
+    out << "code object " << code.name_ << "\n";
+    for (size_t i = 0; i < code.code_.size(); i++) {
+        const Instruction &ins = code.code_[i];
+        out << i << "\t" << opcode_name(ins.op_) << "\t" << ins.arg_;
+        switch (ins.op_) {
+            case OP_LOAD_NAME:
+                out << "\t(" << code.names_[ins.arg_] << ")";
+                break;
+            case OP_LOAD_FAST:
+            case OP_STORE_FAST:
+                out << "\t(" << code.locals_.names_[ins.arg_] << ")";
+                break;
+            case OP_CALL:
+            case OP_THREAD_SPAWN:
+                out << "\t(" << code.names_[code.call_sites_[ins.arg_].name_] << ")";
+                break;
+            case OP_MAKE_FUNCTION:
+                out << "\t(" << code.functions_[ins.arg_]->name() << ")";
+                break;
+            case OP_RAISE:
+                out << "\t(" << code.messages_[ins.arg_] << ")";
+                break;
+            default:
+                break;
+        }
+        out << "\n";
+    }
+    return out.str();
+}
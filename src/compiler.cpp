@@ -0,0 +1,419 @@
+#include "compiler.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "scope.h"
+
+
+using namespace yapvm::compiler;
+using namespace yapvm::bytecode;
+using namespace yapvm::ast;
+using namespace yapvm;
+
+
+namespace {
+
+// names assigned in body are locals of its code object, bodies of nested functions have their own
+void collect_locals(const std::vector<scoped_ptr<Stmt>> &body, interpreter::SlotLayout &locals) {
+    for (const scoped_ptr<Stmt> &s : body) {
+        switch (s->kind()) {
+            case NodeKind::Assign: {
+                Assign *assign = static_cast<Assign *>(s.get());
+                if (assign->target().size() == 1 && assign->target()[0]->kind() == NodeKind::Name) {
+                    locals.add(static_cast<Name *>(assign->target()[0].get())->id());
+                }
+                break;
+            }
+            case NodeKind::While:
+                collect_locals(static_cast<While *>(s.get())->body(), locals);
+                break;
+            case NodeKind::If:
+                collect_locals(static_cast<If *>(s.get())->body(), locals);
+                collect_locals(static_cast<If *>(s.get())->orelse(), locals);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+
+// unsupported constructions are compiled to OP_RAISE, so they fail only if executed, same as in ast interpreter
+class CodeBuilder {
+    Program *program_;
+    CodeObject *code_;
+    std::unordered_map<Symbol, uint32_t> names_idx_;
+
+public:
+    CodeBuilder(Program *program, CodeObject *code) : program_{ program }, code_{ code } {}
+
+    size_t emit(OpCode op, uint32_t arg = 0) {
+        code_->code_.push_back(Instruction{ op, arg });
+        return code_->code_.size() - 1;
+    }
+
+    size_t here() const {
+        return code_->code_.size();
+    }
+
+    void patch(size_t instr, size_t target) {
+        code_->code_[instr].arg_ = static_cast<uint32_t>(target);
+    }
+
+    uint32_t name(Symbol name) {
+        if (auto it = names_idx_.find(name); it != names_idx_.end()) {
+            return it->second;
+        }
+        code_->names_.push_back(name);
+        uint32_t idx = static_cast<uint32_t>(code_->names_.size() - 1);
+        names_idx_.emplace(name, idx);
+        return idx;
+    }
+
+    void raise(std::string message) {
+        code_->messages_.push_back(std::move(message));
+        emit(OP_RAISE, static_cast<uint32_t>(code_->messages_.size() - 1));
+    }
+
+    uint32_t call_site(Symbol func_name, size_t argc) {
+        code_->call_sites_.push_back(CallSite{
+            name(interpreter::Scope::scope_entry_function_name(func_name.str())),
+            static_cast<uint32_t>(argc)
+        });
+        return static_cast<uint32_t>(code_->call_sites_.size() - 1);
+    }
+
+    void constant(const yobjects::YObject *c_val) {
+        Value c_val_cpy{};
+        if (c_val->get_type() == YType::Bool) {
+            c_val_cpy = Value::from_bool(c_val->get_value_as_bool());
+        } else if (c_val->get_type() == YType::Int) {
+            c_val_cpy = Value::from_int(c_val->get_value_as_int());
+        } else if (c_val->get_type() == YType::Float) {
+            c_val_cpy = Value::from_float(c_val->get_value_as_float());
+        } else if (c_val->get_type() == YType::String) {
+            c_val_cpy = new ManagedObject{ yobjects::constr_ystring(c_val->get_value_as_string()) };
+        }
+        assert(!c_val_cpy.is_object() || c_val_cpy.object() != nullptr);
+        code_->consts_.push_back(c_val_cpy);
+        emit(OP_LOAD_CONST, static_cast<uint32_t>(code_->consts_.size() - 1));
+    }
+
+    void function_def(FunctionDef *fdef);
+
+    void stmts(const std::vector<scoped_ptr<Stmt>> &body);
+    void stmt(Stmt *code);
+    void expr(Expr *code);
+    void call(Call *call);
+};
+
+
+void CodeBuilder::function_def(FunctionDef *fdef) {
+    scoped_ptr<CodeObject> function = new CodeObject{ fdef->name(), fdef };
+    CodeBuilder builder{ program_, function.get() };
+    for (Symbol arg : fdef->args()) {
+        function->locals_.add(arg);
+    }
+    collect_locals(fdef->body(), function->locals_);
+
+    builder.emit(OP_SAFEPOINT);
+    builder.stmts(fdef->body());
+    if (fdef->body().empty() || fdef->body().back()->kind() != NodeKind::Return) {
+        builder.raise("Interpreter: function should end with return statement");
+    }
+    function->init_call_caches();
+    program_->add_function(std::move(function));
+
+    code_->functions_.push_back(fdef);
+    emit(OP_MAKE_FUNCTION, static_cast<uint32_t>(code_->functions_.size() - 1));
+}
+
+
+void CodeBuilder::stmts(const std::vector<scoped_ptr<Stmt>> &body) {
+    for (const scoped_ptr<Stmt> &s : body) {
+        stmt(s);
+    }
+}
+
+
+void CodeBuilder::stmt(Stmt *code) {
+    assert(code != nullptr);
+
+    switch (code->kind()) {
+        case NodeKind::Import: {
+            return; // currently just ignore
+        }
+        case NodeKind::FunctionDef: {
+            function_def(static_cast<FunctionDef *>(code));
+            return;
+        }
+        case NodeKind::ClassDef: {
+            raise("Interpreter: ClassDef currently not supported");
+            return;
+        }
+        case NodeKind::Return: {
+            Return *rt = static_cast<Return *>(code);
+            if (rt->returns_anything()) {
+                expr(rt->value());
+                emit(OP_RETURN_VALUE);
+            } else {
+                emit(OP_RETURN_NONE);
+            }
+            return;
+        }
+        case NodeKind::Assign: {
+            Assign *assign = static_cast<Assign *>(code);
+            if (assign->target().size() != 1 || (assign->target()[0]->kind() != NodeKind::Name && assign->target()[0]->kind() != NodeKind::Subscript)) {
+                raise("Interpreter: currently can assign only to single Name");
+                return;
+            }
+            if (assign->target()[0]->kind() == NodeKind::Name) {
+                Name *target = static_cast<Name *>(assign->target()[0].get());
+                expr(assign->value());
+                emit(OP_STORE_FAST, code_->locals_.add(target->id()));
+            } else {
+                Subscript *subscript = static_cast<Subscript *>(assign->target()[0].get());
+                expr(subscript->value());
+                expr(subscript->key());
+                expr(assign->value());
+                emit(OP_STORE_SUBSCR);
+            }
+            return;
+        }
+        case NodeKind::AugAssign: {
+            AugAssign *aug_assign = static_cast<AugAssign *>(code);
+            expr(aug_assign->target());
+            if (aug_assign->op()->kind() != NodeKind::Add) {
+                raise("Interpreter: currently AugAssign for lists supported only for Add");
+                return;
+            }
+            expr(aug_assign->value());
+            emit(OP_INPLACE_ADD);
+            return;
+        }
+        case NodeKind::While: {
+            While *while_ = static_cast<While *>(code);
+            size_t loop_start = here();
+            emit(OP_SAFEPOINT);
+            expr(while_->test());
+            size_t exit_jump = emit(OP_POP_JUMP_IF_FALSE);
+            stmts(while_->body());
+            emit(OP_JUMP, static_cast<uint32_t>(loop_start));
+            patch(exit_jump, here());
+            return;
+        }
+        case NodeKind::For: {
+            raise("Interpreter: currently only while loops are supported");
+            return;
+        }
+        case NodeKind::With: {
+            raise("Interpreter: currently With are not supported");
+            return;
+        }
+        case NodeKind::If: {
+            If *if_ = static_cast<If *>(code);
+            expr(if_->test());
+            size_t else_jump = emit(OP_POP_JUMP_IF_FALSE);
+            stmts(if_->body());
+            if (if_->orelse().empty()) {
+                patch(else_jump, here());
+                return;
+            }
+            size_t end_jump = emit(OP_JUMP);
+            patch(else_jump, here());
+            stmts(if_->orelse());
+            patch(end_jump, here());
+            return;
+        }
+        case NodeKind::ExprStmt: {
+            expr(static_cast<ExprStmt *>(code)->value());
+            emit(OP_POP);
+            return;
+        }
+        case NodeKind::Pass: {
+            return;
+        }
+        case NodeKind::Continue:
+        case NodeKind::Break: {
+            raise("Interpreter: in current version Break and Continue statements are not supported");
+            return;
+        }
+        default:
+            break;
+    }
+
+    throw std::runtime_error("Compiler: unexpected statement");
+}
+
+
+void CodeBuilder::call(Call *call) {
+    if (call->func()->kind() == NodeKind::Attribute) {
+        Attribute *attribute = static_cast<Attribute *>(call->func().get());
+        expr(attribute->value());
+        if (attribute->attr() != "append") {
+            raise("Interpreter: Currently supported only list.append as attribute");
+            return;
+        }
+        if (call->args().size() != 1) {
+            raise("Interpreter: list.append require 1 argument");
+            return;
+        }
+        expr(call->args()[0]);
+        emit(OP_LIST_APPEND);
+        return;
+    }
+    if (call->func()->kind() != NodeKind::Name) {
+        raise("Interpreter: Call.func should be Name");
+        return;
+    }
+
+    Symbol func_name = static_cast<Name *>(call->func().get())->id();
+    if (func_name == "print") {
+        if (call->args().size() != 1) {
+            raise("Interpreter: print can take only 1 argument");
+            return;
+        }
+        expr(call->args()[0]);
+        emit(OP_PRINT);
+        return;
+    }
+    if (func_name == interpreter::Scope::yapvm_thread_func_name) {
+        if (call->args().size() != 2) {
+            raise("Interpreter: thread should have 2 params - function and args to call");
+            return;
+        }
+        if (call->args()[0]->kind() != NodeKind::Name) {
+            raise("Interpreter: thread first argument should be function name");
+            return;
+        }
+        expr(call->args()[1]);
+        emit(OP_THREAD_SPAWN, call_site(static_cast<Name *>(call->args()[0].get())->id(), 1));
+        return;
+    }
+    if (func_name == interpreter::Scope::yapvm_thread_join_func_name) {
+        if (call->args().size() != 1) {
+            raise("Interpreter: thread join can have only one argument");
+            return;
+        }
+        expr(call->args()[0]);
+        emit(OP_THREAD_JOIN);
+        return;
+    }
+    if (func_name == "str" || func_name == "int" || func_name == "float") {
+        if (call->args().size() != 1) {
+            raise("Interpreter: " + func_name.str() + " can take only 1 argument");
+            return;
+        }
+        expr(call->args()[0]);
+        Conversion conv = CONV_STR;
+        if (func_name == "int") {
+            conv = CONV_INT;
+        } else if (func_name == "float") {
+            conv = CONV_FLOAT;
+        }
+        emit(OP_CONVERT, conv);
+        return;
+    }
+    if (func_name == "list") {
+        if (!call->args().empty()) {
+            raise("Interpreter: list constructor cannot take arguments");
+            return;
+        }
+        emit(OP_BUILD_LIST);
+        return;
+    }
+
+    for (Expr *e : call->args()) {
+        expr(e);
+    }
+    emit(OP_CALL, call_site(func_name, call->args().size()));
+}
+
+
+void CodeBuilder::expr(Expr *code) {
+    assert(code != nullptr);
+
+    switch (code->kind()) {
+        case NodeKind::BoolOp: {
+            BoolOp *bool_op = static_cast<BoolOp *>(code);
+            for (Expr *e : bool_op->values()) {
+                expr(e);
+            }
+            OpCode op = bool_op->op()->kind() == NodeKind::And ? OP_BOOL_AND : OP_BOOL_OR;
+            emit(op, static_cast<uint32_t>(bool_op->values().size()));
+            return;
+        }
+        case NodeKind::BinOp: {
+            BinOp *bin_op = static_cast<BinOp *>(code);
+            expr(bin_op->left());
+            expr(bin_op->right());
+            emit(OP_BINARY, binary_operator(bin_op->op()));
+            return;
+        }
+        case NodeKind::UnaryOp: {
+            UnaryOp *unary_op = static_cast<UnaryOp *>(code);
+            expr(unary_op->operand());
+            emit(OP_UNARY, unary_operator(unary_op->op()));
+            return;
+        }
+        case NodeKind::Compare: {
+            Compare *compare = static_cast<Compare *>(code);
+            if (compare->comparators().size() != 1) {
+                raise("Interpreter: Compare currently supported only with one argument");
+                return;
+            }
+            expr(compare->left());
+            expr(compare->comparators()[0]);
+            emit(OP_COMPARE, compare_operator(compare->ops()[0]));
+            return;
+        }
+        case NodeKind::Call: {
+            call(static_cast<Call *>(code));
+            return;
+        }
+        case NodeKind::Constant: {
+            constant(static_cast<Constant *>(code)->value());
+            return;
+        }
+        case NodeKind::Name: {
+            Symbol id = static_cast<Name *>(code)->id();
+            if (std::optional<uint32_t> slot = code_->locals_.find(id); slot.has_value()) {
+                emit(OP_LOAD_FAST, slot.value());
+            } else {
+                emit(OP_LOAD_NAME, name(id));
+            }
+            return;
+        }
+        case NodeKind::Subscript: {
+            Subscript *subscript = static_cast<Subscript *>(code);
+            expr(subscript->value());
+            expr(subscript->key());
+            emit(OP_LOAD_SUBSCR);
+            return;
+        }
+        default:
+            break;
+    }
+
+    raise("Interpreter: unexpected expression");
+}
+
+} // namespace
+
+
+scoped_ptr<Program> yapvm::compiler::compile(Module *module) {
+    scoped_ptr<CodeObject> module_code = new CodeObject{ "<module>", nullptr };
+    CodeObject *code = module_code.get();
+    scoped_ptr<Program> program = new Program{ std::move(module_code) };
+
+    CodeBuilder builder{ program.get(), code };
+    collect_locals(module->body(), code->locals_);
+    builder.stmts(module->body());
+    builder.emit(OP_RETURN_NONE);
+    code->init_call_caches();
+    return program;
+}
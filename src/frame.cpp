@@ -0,0 +1,67 @@
+#include "frame.h"
+
+#include <algorithm>
+
+
+using namespace yapvm::interpreter;
+
+
+static_assert(sizeof(Frame) % alignof(yapvm::yobjects::Value) == 0);
+
+
+Scope *yapvm::interpreter::Frame::dynamic_scope() {
+    if (dynamic_ == nullptr) {
+        dynamic_ = new Scope{ nullptr };
+        dynamic_->set_frame_local();
+    }
+    return dynamic_;
+}
+
+
+std::optional<ScopeEntry> yapvm::interpreter::Frame::get(Symbol name) {
+    if (std::optional<uint32_t> idx = code_->locals_.find(name); idx.has_value()) {
+        Value &v = slots()[idx.value()];
+        if (!Scope::is_unbound(v)) {
+            return ScopeEntry{ nullptr, OBJECT, v };
+        }
+    }
+    if (dynamic_ != nullptr) {
+        return dynamic_->get(name);
+    }
+    return std::nullopt;
+}
+
+
+Frame *yapvm::interpreter::FrameStack::push(const bytecode::CodeObject *code, Frame *caller) {
+    uint32_t slots_count = static_cast<uint32_t>(code->locals_.names_.size());
+    size_t size = sizeof(Frame) + slots_count * sizeof(Value);
+
+    size_t block = block_;
+    size_t top = top_;
+    if (blocks_.empty() || top + size > blocks_[block].size_) {
+        // next block, frames never span two blocks
+        block = blocks_.empty() ? 0 : block + 1;
+        top = 0;
+        if (block == blocks_.size()) {
+            blocks_.emplace_back();
+        }
+        if (blocks_[block].size_ < size) {
+            size_t block_size = std::max(BLOCK_BYTES, size);
+            blocks_[block] = Block{ std::make_unique<std::byte[]>(block_size), block_size };
+        }
+    }
+
+    Frame *frame = reinterpret_cast<Frame *>(blocks_[block].data_.get() + top);
+    new (frame) Frame{ caller, code, nullptr, block_, top_, slots_count };
+    std::uninitialized_fill_n(frame->slots(), slots_count, Value{});
+    block_ = block;
+    top_ = top + size;
+    return frame;
+}
+
+
+void yapvm::interpreter::FrameStack::pop(Frame *frame) {
+    delete frame->dynamic_;
+    block_ = frame->prev_block_;
+    top_ = frame->prev_top_;
+}
@@ -1,76 +1,459 @@
 #include "gc.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <deque>
+#include <cstdio>
+#include <memory>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 
 #include "interpreter.h"
 #include "logger.h"
-
-#define sleepns(val) std::this_thread::sleep_for(std::chrono::nanoseconds(val));
-#define sleepms(val) std::this_thread::sleep_for(std::chrono::milliseconds(val));
+#include "mark_deque.h"
 
 using namespace yapvm::ygc;
 
-void YGC::mark() {
-    std::deque<ManagedObject *> deq;
-    // all root objects, no nullptr's here 
-    std::vector<ManagedObject *> root_objects = root_->get_all_objects();
-    for (ManagedObject *obj : root_objects) {
+static std::vector<Interpreter *> live_interpreters(ThreadManager *tm) {
+    std::optional<std::vector<Interpreter *>> opt_interprets = tm->get_all_interpreters();
+    while (!opt_interprets.has_value()) {
+        opt_interprets = tm->get_all_interpreters();
+    }
+    return opt_interprets.value();
+}
+
+
+static uint64_t ns_since(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+
+static void add_phase(std::string &kind, const std::string &phase) {
+    kind += kind.empty() ? phase : "+" + phase;
+}
+
+
+// header and payload, containers are estimated by elements count
+static uint64_t shallow_size(ManagedObject *obj) {
+    YObject *value = obj->value();
+    uint64_t size = sizeof(ManagedObject);
+    switch (value->get_type()) {
+        case YType::String:
+            size += value->get_value_as_string().size();
+            break;
+        case YType::List:
+            size += value->get_len_as_list() * sizeof(Value);
+            break;
+        case YType::Dict:
+            size += get_dict_elements(value).size() * sizeof(ManagedObject *);
+            break;
+        default:
+            break;
+    }
+    return size + value->get_fields_names().size() * (sizeof(yapvm::Symbol) + sizeof(ManagedObject *));
+}
+
+
+static void forward_value(Value &v) {
+    ManagedObject *obj = v.object();
+    if (obj != nullptr && obj->forward() != nullptr) {
+        v = obj->forward();
+    }
+}
+
+
+static void forward_ref(ManagedObject *&ref) {
+    if (ref != nullptr && ref->forward() != nullptr) {
+        ref = ref->forward();
+    }
+}
+
+
+void YGC::minor() {
+    std::vector<ManagedObject *> remembered = take_remembered();
+    std::vector<ManagedObject *> traced; // marked in this collection, young and untracked
+    std::vector<ManagedObject *> gray;
+    std::unordered_set<ManagedObject *> pinned;
+
+    auto reach = [&](ManagedObject *obj) {
+        if (obj == nullptr || obj->generation() == Generation::Old || obj->is_marked()) {
+            return;
+        }
         obj->mark();
-        deq.push_back(obj);
+        traced.push_back(obj);
+        gray.push_back(obj);
+    };
+    auto scan = [&](ManagedObject *obj) {
+        obj->visit_slots([&](Value &v) { reach(v.object()); }, reach);
+        // dict keys can't be moved without rehashing, so dict elements are promoted in place
+        if (obj->value()->get_type() == YType::Dict) {
+            for (ManagedObject *kid : get_dict_elements(obj->value())) {
+                reach(kid);
+                pinned.insert(kid);
+            }
+        }
+    };
+
+    visit_roots([&](Value &v) { reach(v.object()); });
+    for (ManagedObject *obj : remembered) {
+        scan(obj);
+    }
+    while (!gray.empty()) {
+        ManagedObject *obj = gray.back();
+        gray.pop_back();
+        scan(obj);
+    }
+
+    // evacuation, copy of young object takes its payload and old one keeps forwarding pointer
+    std::vector<ManagedObject *> survivors;
+    memory::set_current_allocator(&old_space_);
+    for (ManagedObject *obj : traced) {
+        if (obj->generation() == Generation::Young && !pinned.contains(obj)) {
+            ManagedObject *copy = new ManagedObject{ std::move(*obj->value()) };
+            copy->set_generation(Generation::Old);
+            obj->set_forward(copy);
+            survivors.push_back(copy);
+            continue;
+        }
+        if (obj->generation() == Generation::Young) {
+            obj->set_generation(Generation::Old);
+            left_.push_back(obj);
+        }
+        obj->unmark();
+        survivors.push_back(obj);
+    }
+    memory::set_current_allocator(nullptr);
+
+    visit_roots(forward_value);
+    for (ManagedObject *obj : remembered) {
+        obj->visit_slots(forward_value, forward_ref);
+        obj->forget();
+    }
+    for (ManagedObject *obj : survivors) {
+        obj->visit_slots(forward_value, forward_ref);
     }
-    size_t counter = root_objects.size();
-    Logger::log("GC", "mark", "found " + std::to_string(counter) + " root objects");
 
-    while (!deq.empty()) {
-        ManagedObject *curr_obj = deq.front();
-        deq.pop_front();
-        std::vector<ManagedObject *> kids;
-        if (is_collection(curr_obj->value())) {
-            kids = get_collection_elements(curr_obj->value());
+    size_t promoted = 0;
+    size_t deleted_ctr = 0;
+    young_.for_each([&](ManagedObject *obj) {
+        if (obj->generation() == Generation::Old) {
+            promoted++; // in place
+            return;
+        }
+        if (obj->forward() != nullptr) {
+            promoted++;
         } else {
-            kids = curr_obj->value()->get_fields();
+            deleted_ctr++;
+        }
+        delete obj;
+    });
+    young_.clear();
+
+    // copying is wasted on nursery where most objects survive, it grows to let them die
+    if (promoted * 2 > promoted + deleted_ctr) {
+        nursery_bytes_ = std::min<size_t>(nursery_bytes_ * 2, GC_NURSERY_MAX_BYTES);
+    } else if (promoted * 8 < promoted + deleted_ctr) {
+        nursery_bytes_ = std::max<size_t>(nursery_bytes_ / 2, GC_NURSERY_BYTES);
+    }
+
+    cycle_.promoted_objects_ += promoted;
+    Logger::log("GC", "minor", "promoted " + std::to_string(promoted) + " young objects, deleted "
+        + std::to_string(deleted_ctr) + ", " + std::to_string(remembered.size()) + " remembered old objects, nursery is "
+        + std::to_string(nursery_bytes_) + " bytes");
+}
+
+
+// marker state, thread i owns deques[i]
+struct MarkWorker {
+    size_t marked_ = 0;
+    std::vector<ManagedObject *> untracked_; // to unmark them in sweep
+};
+
+
+static void mark_object(ManagedObject *obj, MarkDeque &deque, MarkWorker &worker) {
+    worker.marked_++;
+    if (obj->generation() == Generation::Untracked) {
+        worker.untracked_.push_back(obj);
+    }
+    deque.push(obj);
+}
+
+
+static void mark_loop(size_t id, std::vector<std::unique_ptr<MarkDeque>> &deques, std::atomic_size_t &idle,
+                      MarkWorker &worker, const std::vector<Interpreter *> &mutators) {
+    MarkDeque &own = *deques[id];
+    // young objects are not swept by major collection, they are left to minor
+    auto reach = [&](ManagedObject *kid) {
+        if (kid != nullptr && kid->generation() != Generation::Young && kid->try_mark()) {
+            mark_object(kid, own, worker);
+        }
+    };
+    auto steal = [&]() -> ManagedObject * {
+        for (size_t i = 1; i < deques.size(); i++) {
+            if (ManagedObject *obj = deques[(id + i) % deques.size()]->steal()) {
+                return obj;
+            }
+        }
+        return nullptr;
+    };
+
+    // marker i scans roots of mutators i, i + n, ..., others may steal its gray objects meanwhile
+    for (size_t i = id; i < mutators.size(); i += deques.size()) {
+        mutators[i]->visit_roots([&](Value &v) { reach(v.object()); });
+    }
+
+    while (true) {
+        ManagedObject *obj = own.pop();
+        if (obj == nullptr) {
+            obj = steal();
+        }
+        if (obj != nullptr) {
+            obj->lock(); // mutators may change it during concurrent mark
+            obj->visit_slots([&](Value &v) { reach(v.object()); }, reach);
+            if (obj->value()->get_type() == YType::Dict) {
+                for (ManagedObject *kid : get_dict_elements(obj->value())) {
+                    reach(kid);
+                }
+            }
+            obj->unlock();
+            continue;
         }
-        if (kids.empty()) continue;
-        for (ManagedObject *kid : kids) {
-            if (!kid->is_marked()) {
-                counter++;
-                kid->mark();
-                deq.push_back(kid);
+
+        // only owners push, so when every marker is idle all deques are empty
+        idle.fetch_add(1);
+        while (true) {
+            if (idle.load() == deques.size()) {
+                return;
+            }
+            bool has_work = false;
+            for (const std::unique_ptr<MarkDeque> &d : deques) {
+                has_work = has_work || !d->empty();
+            }
+            if (has_work) {
+                idle.fetch_sub(1);
+                break;
             }
+            std::this_thread::yield();
         }
     }
-    Logger::log("GC", "mark", "marked " + std::to_string(counter) + " live objects");
 }
 
-static bool is_unique(const std::vector<ManagedObject *> &muobj) {
-    std::unordered_set<ManagedObject *> objs;
-    for (ManagedObject *m : muobj) {
-        if (objs.contains(m)) {
-            return false;
+
+void YGC::visit_roots(const std::function<void(Value &)> &visit) {
+    // root scope outlives main interpreter, then threads left are visited by gc itself
+    if (!root_->is_thread_root()) {
+        root_->visit_values(visit);
+    }
+    for (Interpreter *i : live_interpreters(tm_)) {
+        i->visit_roots(visit);
+    }
+}
+
+
+std::vector<ManagedObject *> YGC::roots() {
+    // all root objects, no nullptr's here
+    std::vector<ManagedObject *> root_objects;
+    visit_roots([&](Value &v) {
+        if (v.object() != nullptr) {
+            root_objects.push_back(v.object());
+        }
+    });
+    return root_objects;
+}
+
+
+void YGC::trace(const std::vector<ManagedObject *> &gray, const std::string &phase,
+                const std::vector<Interpreter *> &mutators) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    size_t n = mark_threads();
+    std::vector<std::unique_ptr<MarkDeque>> deques;
+    std::vector<MarkWorker> workers{ n };
+    for (size_t i = 0; i < n; i++) {
+        deques.push_back(std::make_unique<MarkDeque>());
+    }
+    // gray objects are dealt round robin before markers start
+    size_t next = 0;
+    for (ManagedObject *obj : gray) {
+        if (obj->generation() != Generation::Young && obj->try_mark()) {
+            mark_object(obj, *deques[next], workers[next]);
+            next = (next + 1) % n;
+        }
+    }
+
+    std::atomic_size_t idle{ 0 };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n; i++) {
+        threads.emplace_back(mark_loop, i, std::ref(deques), std::ref(idle), std::ref(workers[i]), std::cref(mutators));
+    }
+    mark_loop(0, deques, idle, workers[0], mutators);
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    size_t counter = 0;
+    std::string per_thread;
+    for (MarkWorker &w : workers) {
+        counter += w.marked_;
+        per_thread += " " + std::to_string(w.marked_);
+        untracked_marked_.insert(untracked_marked_.end(), w.untracked_.begin(), w.untracked_.end());
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    cycle_.mark_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    Logger::log("GC", phase, "marked " + std::to_string(counter) + " live objects by " + std::to_string(n)
+        + " threads in " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count())
+        + " [us], per thread:" + per_thread);
+}
+
+
+void YGC::mark() {
+    old_space_.finish_sweep(); // marks of previous cycle are cleared by sweep
+    std::vector<ManagedObject *> root_objects;
+    if (!root_->is_thread_root()) {
+        root_->visit_values([&](Value &v) {
+            if (v.object() != nullptr) {
+                root_objects.push_back(v.object());
+            }
+        });
+    }
+    std::vector<Interpreter *> mutators = live_interpreters(tm_);
+    Logger::log("GC", "mark", "found " + std::to_string(root_objects.size()) + " objects in root scope, "
+        + std::to_string(mutators.size()) + " threads roots are scanned by markers");
+    trace(root_objects, "mark", mutators);
+}
+
+
+void YGC::initial_mark() {
+    minor(); // nursery is empty and no objects move until remark
+    old_space_.finish_sweep();
+    snapshot_ = roots();
+    marking_active = true;
+    Logger::log("GC", "initial mark", "found " + std::to_string(snapshot_.size()) + " root objects");
+}
+
+
+void YGC::concurrent_mark() {
+    trace(snapshot_, "concurrent mark");
+    snapshot_ = {};
+}
+
+
+void YGC::remark() {
+    marking_active = false;
+    std::vector<ManagedObject *> overwritten = take_satb();
+    Logger::log("GC", "remark", std::to_string(overwritten.size()) + " references logged by mutators");
+    trace(overwritten, "remark");
+    sweep();
+}
+
+
+void YGC::compact() {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    old_space_.finish_sweep();
+
+    // mark, dead objects of evacuated chunks are freed instead of moving
+    std::vector<ManagedObject *> reached;
+    std::vector<ManagedObject *> gray;
+    std::unordered_set<ManagedObject *> pinned;
+    auto reach = [&](ManagedObject *obj) {
+        if (obj != nullptr && obj->try_mark()) {
+            reached.push_back(obj);
+            gray.push_back(obj);
+        }
+    };
+    visit_roots([&](Value &v) { reach(v.object()); });
+    while (!gray.empty()) {
+        ManagedObject *obj = gray.back();
+        gray.pop_back();
+        obj->visit_slots([&](Value &v) { reach(v.object()); }, reach);
+        if (obj->value()->get_type() == YType::Dict) {
+            for (ManagedObject *kid : get_dict_elements(obj->value())) {
+                reach(kid);
+                pinned.insert(kid);
+            }
+        }
+    }
+    cycle_.mark_ns_ += ns_since(begin);
+
+    std::vector<void *> cells = old_space_.start_evacuation(GC_COMPACT_OCCUPANCY);
+    size_t moved = 0;
+    size_t deleted_ctr = 0;
+    memory::set_current_allocator(&old_space_);
+    for (void *cell : cells) {
+        ManagedObject *obj = static_cast<ManagedObject *>(cell);
+        if (!obj->is_marked()) {
+            delete obj;
+            deleted_ctr++;
+        } else if (!pinned.contains(obj)) {
+            ManagedObject *copy = new ManagedObject{ std::move(*obj->value()) };
+            copy->set_generation(Generation::Old);
+            copy->mark();
+            obj->set_forward(copy);
+            moved++;
         }
-        objs.insert(m);
     }
-    std::unordered_set<YObject *> objs_y;
-    for (ManagedObject *m : muobj) {
-        if (objs_y.contains(m->value())) {
-            return false;
+    memory::set_current_allocator(nullptr);
+
+    visit_roots(forward_value);
+    for (ManagedObject *obj : reached) {
+        ManagedObject *target = obj->forward() != nullptr ? obj->forward() : obj;
+        target->visit_slots(forward_value, forward_ref);
+    }
+    for (ManagedObject *obj : reached) {
+        if (obj->forward() != nullptr) {
+            delete obj;
+        } else if (obj->generation() == Generation::Untracked) {
+            untracked_marked_.push_back(obj);
         }
-        objs_y.insert(m->value());
     }
-    return true;
+    size_t released = old_space_.finish_evacuation();
+    compacted_ = true;
+
+    // marks are complete, so rest of dead objects is freed as after major mark
+    sweep();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    Logger::log("GC", "compact", "moved " + std::to_string(moved) + " objects, pinned " + std::to_string(pinned.size())
+        + ", freed " + std::to_string(deleted_ctr) + " dead objects of " + std::to_string(released)
+        + " released chunks in " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count())
+        + " [us]");
+}
+
+
+void YGC::set_compaction(bool enabled) {
+    compaction_ = enabled;
+}
+
+
+double YGC::fragmentation() const {
+    return old_space_.fragmentation();
+}
+
+
+void YGC::set_mark_threads(size_t n) {
+    mark_threads_ = n;
+}
+
+
+size_t YGC::mark_threads() const {
+    if (mark_threads_ != 0) {
+        return mark_threads_;
+    }
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+
+void YGC::finalize(void *obj) {
+    static_cast<ManagedObject *>(obj)->~ManagedObject();
 }
 
+
 void YGC::sweep() {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
     size_t deleted_ctr = 0;
-    assert(is_unique(left_));
     for (ManagedObject *obj : left_) {
         if (!obj->is_marked()) {
             delete(obj);
             deleted_ctr++;
-            if (need_check_hs_) max_hs_ += sizeof(ManagedObject);
         } else {
             obj->unmark();
             right_.push_back(obj);
@@ -78,37 +461,151 @@ void YGC::sweep() {
     }
     left_.swap(right_);
     right_ = {};
+    for (ManagedObject *obj : untracked_marked_) {
+        obj->unmark();
+    }
+    untracked_marked_.clear();
+    old_space_.start_sweep();
+    sweep_pending_ = true;
+    cycle_.sweep_ns_ += ns_since(begin);
 
-    Logger::log("GC", "sweep", "deleted " + std::to_string(deleted_ctr) + " dead objects");
+    Logger::log("GC", "sweep", "deleted " + std::to_string(deleted_ctr) + " dead objects out of old space, "
+        + std::to_string(old_space_.chunks()) + " old space chunks are left for lazy sweep");
 }
 
 void YGC::fill_left(std::vector<ManagedObject *> &vec) {
     for (ManagedObject *obj : vec) {
+        obj->set_generation(Generation::Old);
         left_.push_back(obj);
     }
 }
 
+void YGC::fill_young(std::vector<ManagedObject *> &vec) {
+    for (ManagedObject *obj : vec) {
+        obj->set_generation(Generation::Young);
+        young_.push(obj);
+    }
+}
+
 std::vector<ManagedObject *> &YGC::left() {
     return left_;
 }
 
+size_t YGC::old_objects() const {
+    return old_space_.live() + left_.size();
+}
+
+void YGC::dump_heap(const std::string &path) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    HeapDump dump;
+    std::vector<ManagedObject *> objects; // by index in dump, breadth-first from roots
+    std::unordered_map<ManagedObject *, uint64_t> index;
+    auto reach = [&](ManagedObject *obj) {
+        auto [it, inserted] = index.try_emplace(obj, objects.size());
+        if (inserted) {
+            objects.push_back(obj);
+        }
+        return it->second;
+    };
+
+    visit_roots([&](Value &v) {
+        if (v.object() != nullptr) {
+            dump.roots_.push_back(reach(v.object()));
+        }
+    });
+    for (size_t i = 0; i < objects.size(); i++) {
+        ManagedObject *obj = objects[i];
+        HeapDump::Object rec{ obj->value()->get_typename_id(), shallow_size(obj), {} };
+        auto edge = [&](ManagedObject *kid) {
+            if (kid != nullptr) {
+                rec.edges_.push_back(reach(kid));
+            }
+        };
+        obj->visit_slots([&](Value &v) { edge(v.object()); }, edge);
+        if (obj->value()->get_type() == YType::Dict) {
+            for (ManagedObject *kid : get_dict_elements(obj->value())) {
+                edge(kid);
+            }
+        }
+        dump.type_names_.try_emplace(rec.type_id_, obj->value()->get_typename());
+        dump.objects_.push_back(std::move(rec));
+    }
+
+    // readers never see half written dump
+    std::string tmp_path = path + ".tmp";
+    dump.write(tmp_path);
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("GC: can't write heap dump " + path);
+    }
+    heap_dumped_ = true;
+    Logger::log("GC", "heap dump", std::to_string(objects.size()) + " objects written to " + path + " in "
+        + std::to_string(ns_since(begin) / 1000) + " [us]");
+}
+
+
+void YGC::set_heap_dump(const std::string &path) {
+    heap_dump_path_ = path;
+}
+
+
+GCStats &YGC::stats() {
+    return stats_;
+}
+
+
+size_t YGC::nursery_budget() const {
+    return std::min(nursery_bytes_, heap_->max_size() / 8);
+}
+
+
+ObjectList &YGC::young() {
+    return young_;
+}
+
+
+bool YGC::has_work() {
+    std::vector<Interpreter *> interprets = live_interpreters(tm_);
+    if (interprets.empty()) {
+        return true; // finishing cycle
+    }
+    for (Interpreter *i : interprets) {
+        if (i->registered() != 0) {
+            return true;
+        }
+    }
+    return !young_.empty() || compact_pending_ || old_objects() >= old_limit_
+        || heap_->committed() >= heap_->max_size() / 4 * 3;
+}
+
 
 void YGC::collect() {
+    bool marking = false; // concurrent mark started in previous cycle
+    size_t skipped = 0; // allocated bytes of checks which found nothing to collect
+    heap_->set_gc_trigger(nursery_budget());
     while (true) {
-        Logger::log("GC", "gc cycle started, parking all threads...");
-        while (!tm_->park_all());
-        std::optional<bool> is_all_parked_opt = tm_->is_all_parked();
-        while (true) {
-            if (is_all_parked_opt.has_value()) {
-                if (!is_all_parked_opt.value()) {
-                    sleepns(1000);
-                } else {
-                    break;
-                }
+        // idle mode, interpreters are parked only after they allocated nursery budget
+        if (!marking && !heap_->wait_for_gc_request(std::chrono::milliseconds{ GC_IDLE_CHECK_MS })) {
+            std::optional<std::vector<Interpreter *>> opt_interprets = tm_->get_all_interpreters();
+            if (!opt_interprets.has_value() || !opt_interprets.value().empty()) {
+                continue;
             }
-            is_all_parked_opt = tm_->is_all_parked();
         }
-        Logger::log("GC", "all threads parked");
+        if (!marking && !has_work()) {
+            skipped += heap_->take_allocated(); // trigger is rearmed, bytes are reported by next cycle
+            Logger::log("GC", "nothing to collect after " + std::to_string(skipped)
+                + " allocated bytes, threads are not parked");
+            continue;
+        }
+        size_t allocated = skipped + heap_->take_allocated();
+        skipped = 0;
+        Logger::log("GC", "gc cycle started after " + std::to_string(allocated) + " allocated bytes, parking all threads...");
+        std::chrono::steady_clock::time_point pause_begin = std::chrono::steady_clock::now();
+        cycle_ = CycleStats{};
+        cycle_.allocated_bytes_ = allocated;
+        while (!tm_->park_all());
+        cycle_.ttsp_ns_ = tm_->safepoint_stats().ttsp_last_ns;
+        Logger::log("GC", "all threads parked, time to safepoint "
+            + std::to_string(tm_->safepoint_stats().ttsp_last_ns / 1000) + " us");
 
         std::vector<Interpreter *> interprets;
         std::optional opt_interprets = tm_->get_all_interpreters();
@@ -122,42 +619,85 @@ void YGC::collect() {
         Logger::log("GC", "get " + std::to_string(interprets.size()) + " live interpreters");
         if (interprets.empty()) {
             Logger::log("GC", "found no live interpreters, finishing...");
+            marking_active = false;
             while (!tm_->finish_waiting()); // join
+            if (!heap_dump_path_.empty() && !heap_dumped_) {
+                dump_heap(heap_dump_path_); // globals left by main interpreter
+            }
+            SafepointStats stats = tm_->safepoint_stats();
+            if (stats.stops != 0) {
+                Logger::log("GC", "safepoint", std::to_string(stats.stops) + " stops, time to safepoint avg "
+                    + std::to_string(stats.ttsp_total_ns / stats.stops / 1000) + " us, max "
+                    + std::to_string(stats.ttsp_max_ns / 1000) + " us, resume avg "
+                    + std::to_string(stats.resume_total_ns / stats.stops / 1000) + " us, max "
+                    + std::to_string(stats.resume_max_ns / 1000) + " us");
+            }
+            Logger::log("GC", "stats", stats_.summary());
+            stats_.finish();
             Logger::log("GC", "all joins finished, exiting...");
             break;
         }
 
         Logger::log("GC", "registering allocated objects");
         for (Interpreter *i : interprets) {
-            std::vector<ManagedObject *> register_queue = i->get_register_queue();
-            for (ManagedObject *mo : register_queue) {
-                if (need_check_hs_) {
-                    if (mo->value()->get_typename() == "string") {
-                        max_hs_ -= static_cast<size_t>(mo->value()->get_value_as_string().size());
-                    }
-                    max_hs_ -= sizeof(ManagedObject);
-                    if (max_hs_ < 0) {
-                        throw std::runtime_error("GC: max heap size exceeded");
-                    }
-                }
+            young_.splice(i->take_register_queue());
+        }
 
-                left_.push_back(mo);
+        if (marking) {
+            add_phase(cycle_.kind_, "remark");
+            remark();
+            marking = false;
+            if (!heap_dump_path_.empty()) {
+                dump_heap(heap_dump_path_);
+            }
+        } else {
+            if (!young_.empty()) {
+                Logger::log("GC", "nursery is full, minor collection of " + std::to_string(young_.size()) + " objects");
+                add_phase(cycle_.kind_, "minor");
+                minor();
+            }
+            if (compact_pending_) {
+                add_phase(cycle_.kind_, "compact");
+                compact(); // it sweeps old generation too
+                compact_pending_ = false;
+                if (!heap_dump_path_.empty()) {
+                    dump_heap(heap_dump_path_);
+                }
+            } else if (old_objects() >= old_limit_ || heap_->committed() >= heap_->max_size() / 4 * 3) {
+                // close to max heap size old generation is collected regardless of its growth
+                Logger::log("GC", "old generation limit over, concurrent mark started...");
+                Logger::log("GC","in heap now " + std::to_string(old_objects() + young_.size()) + " objects");
+                add_phase(cycle_.kind_, "initial_mark");
+                initial_mark();
+                marking = true;
             }
-        }
-        
-        if (left_.size() >= GC_CASH_LIMIT) {
-            Logger::log("GC", "GC_CASH_LIMIT over, mark and sweep started...");
-            Logger::log("GC","in heap now " + std::to_string(left_.size()) + " objects");
-            mark();
-            sweep();
         }
 
+        heap_->set_gc_trigger(nursery_budget());
         Logger::log("GC", "gc cycle end, running all threads...");
         while (!tm_->run_all());
+        cycle_.pause_ns_ = ns_since(pause_begin);
+
+        if (marking) {
+            concurrent_mark(); // interpreters run meanwhile, remark is done in next cycle
+        } else if (sweep_pending_) {
+            // rest of old space is swept while interpreters run, promotion sweeps chunks it reaches itself
+            std::chrono::steady_clock::time_point sweep_begin = std::chrono::steady_clock::now();
+            size_t deleted_ctr = old_space_.finish_sweep();
+            cycle_.sweep_ns_ += ns_since(sweep_begin);
+            sweep_pending_ = false;
+            old_limit_ = std::max<size_t>(GC_CASH_LIMIT, GC_HEAP_GROWTH * old_objects());
+            Logger::log("GC", "sweep", "lazily swept " + std::to_string(deleted_ctr) + " dead objects, "
+                + std::to_string(heap_->committed()) + " bytes committed in chunks, old space fragmentation "
+                + std::to_string(old_space_.fragmentation()));
+            compact_pending_ = compaction_ && !compacted_ && old_space_.chunks() >= GC_COMPACT_MIN_CHUNKS
+                && old_space_.fragmentation() >= GC_COMPACT_FRAGMENTATION;
+            compacted_ = false;
+        }
 
-        sleepms(1000);
+        cycle_.freed_bytes_ = heap_->take_freed();
+        cycle_.committed_bytes_ = heap_->committed();
+        cycle_.live_objects_ = old_objects();
+        stats_.record(std::move(cycle_));
     }
 }
-
-
-
@@ -0,0 +1,96 @@
+#include "gc_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+using namespace yapvm::ygc;
+
+
+std::string yapvm::ygc::CycleStats::to_json() const {
+    return "{\"cycle\":" + std::to_string(cycle_)
+        + ",\"kind\":\"" + kind_ + "\""
+        + ",\"ttsp_ns\":" + std::to_string(ttsp_ns_)
+        + ",\"pause_ns\":" + std::to_string(pause_ns_)
+        + ",\"mark_ns\":" + std::to_string(mark_ns_)
+        + ",\"sweep_ns\":" + std::to_string(sweep_ns_)
+        + ",\"allocated_bytes\":" + std::to_string(allocated_bytes_)
+        + ",\"freed_bytes\":" + std::to_string(freed_bytes_)
+        + ",\"committed_bytes\":" + std::to_string(committed_bytes_)
+        + ",\"promoted_objects\":" + std::to_string(promoted_objects_)
+        + ",\"live_objects\":" + std::to_string(live_objects_) + "}";
+}
+
+
+void yapvm::ygc::GCStats::open(const std::string &path) {
+    std::lock_guard lock{ monitor_ };
+    out_ = std::ofstream(path);
+    if (!out_.is_open()) {
+        throw std::runtime_error("GCStats: can't open " + path);
+    }
+}
+
+
+void yapvm::ygc::GCStats::record(CycleStats stats) {
+    std::lock_guard lock{ monitor_ };
+    stats.cycle_ = cycles_.size() + 1;
+    if (out_.is_open()) {
+        out_ << stats.to_json() << '\n';
+    }
+    cycles_.push_back(std::move(stats));
+}
+
+
+std::vector<CycleStats> yapvm::ygc::GCStats::cycles() const {
+    std::lock_guard lock{ monitor_ };
+    return cycles_;
+}
+
+
+uint64_t yapvm::ygc::GCStats::pause_percentile(double p) const {
+    std::lock_guard lock{ monitor_ };
+    if (cycles_.empty()) {
+        return 0;
+    }
+    std::vector<uint64_t> pauses;
+    for (const CycleStats &c : cycles_) {
+        pauses.push_back(c.pause_ns_);
+    }
+    std::sort(pauses.begin(), pauses.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(pauses.size())));
+    return pauses[std::clamp<size_t>(rank, 1, pauses.size()) - 1];
+}
+
+
+std::string yapvm::ygc::GCStats::summary() const {
+    uint64_t p50 = pause_percentile(0.5);
+    uint64_t p99 = pause_percentile(0.99);
+    std::lock_guard lock{ monitor_ };
+    uint64_t max = 0;
+    uint64_t total = 0;
+    size_t allocated = 0;
+    size_t freed = 0;
+    for (const CycleStats &c : cycles_) {
+        max = std::max(max, c.pause_ns_);
+        total += c.pause_ns_;
+        allocated += c.allocated_bytes_;
+        freed += c.freed_bytes_;
+    }
+    return "{\"cycles\":" + std::to_string(cycles_.size())
+        + ",\"pause_p50_ns\":" + std::to_string(p50)
+        + ",\"pause_p99_ns\":" + std::to_string(p99)
+        + ",\"pause_max_ns\":" + std::to_string(max)
+        + ",\"pause_total_ns\":" + std::to_string(total)
+        + ",\"allocated_bytes\":" + std::to_string(allocated)
+        + ",\"freed_bytes\":" + std::to_string(freed) + "}";
+}
+
+
+void yapvm::ygc::GCStats::finish() {
+    std::string line = "{\"summary\":" + summary() + "}";
+    std::lock_guard lock{ monitor_ };
+    if (out_.is_open()) {
+        out_ << line << std::endl;
+    }
+}
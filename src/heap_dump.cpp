@@ -0,0 +1,258 @@
+#include "heap_dump.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+using namespace yapvm::ygc;
+
+
+template <typename T>
+static void put(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+
+template <typename T>
+static T get(std::istream &in) {
+    T value;
+    if (!in.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+        throw std::runtime_error("HeapDump: unexpected end of file");
+    }
+    return value;
+}
+
+
+static uint64_t get_index(std::istream &in, uint64_t objects) {
+    uint64_t idx = get<uint64_t>(in);
+    if (idx >= objects) {
+        throw std::runtime_error("HeapDump: invalid object index " + std::to_string(idx));
+    }
+    return idx;
+}
+
+
+void yapvm::ygc::HeapDump::write(const std::string &path) const {
+    std::ofstream out{ path, std::ios::binary };
+    if (!out.is_open()) {
+        throw std::runtime_error("HeapDump: can't open " + path);
+    }
+    out.write(MAGIC, sizeof(MAGIC));
+    put<uint32_t>(out, VERSION);
+
+    put<uint32_t>(out, type_names_.size());
+    for (const auto &[id, name] : type_names_) {
+        put<uint32_t>(out, id);
+        put<uint32_t>(out, name.size());
+        out.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    put<uint64_t>(out, roots_.size());
+    for (uint64_t idx : roots_) {
+        put<uint64_t>(out, idx);
+    }
+
+    put<uint64_t>(out, objects_.size());
+    for (const Object &obj : objects_) {
+        put<uint32_t>(out, obj.type_id_);
+        put<uint64_t>(out, obj.size_);
+        put<uint32_t>(out, obj.edges_.size());
+        for (uint64_t idx : obj.edges_) {
+            put<uint64_t>(out, idx);
+        }
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("HeapDump: can't write " + path);
+    }
+}
+
+
+HeapDump yapvm::ygc::HeapDump::read(const std::string &path) {
+    std::ifstream in{ path, std::ios::binary };
+    if (!in.is_open()) {
+        throw std::runtime_error("HeapDump: can't open " + path);
+    }
+    char magic[sizeof(MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("HeapDump: " + path + " is not a heap dump");
+    }
+    if (get<uint32_t>(in) != VERSION) {
+        throw std::runtime_error("HeapDump: unsupported version of " + path);
+    }
+
+    HeapDump dump;
+    uint32_t types = get<uint32_t>(in);
+    for (uint32_t i = 0; i < types; i++) {
+        uint32_t id = get<uint32_t>(in);
+        std::string name(get<uint32_t>(in), '\0');
+        if (!in.read(name.data(), static_cast<std::streamsize>(name.size()))) {
+            throw std::runtime_error("HeapDump: unexpected end of file");
+        }
+        dump.type_names_[id] = std::move(name);
+    }
+
+    // indices are checked when objects count is known
+    std::vector<uint64_t> roots(get<uint64_t>(in));
+    for (uint64_t &idx : roots) {
+        idx = get<uint64_t>(in);
+    }
+    uint64_t objects = get<uint64_t>(in);
+    for (uint64_t idx : roots) {
+        if (idx >= objects) {
+            throw std::runtime_error("HeapDump: invalid object index " + std::to_string(idx));
+        }
+    }
+    dump.roots_ = std::move(roots);
+
+    for (uint64_t i = 0; i < objects; i++) {
+        Object obj;
+        obj.type_id_ = get<uint32_t>(in);
+        obj.size_ = get<uint64_t>(in);
+        obj.edges_.resize(get<uint32_t>(in));
+        for (uint64_t &idx : obj.edges_) {
+            idx = get_index(in, objects);
+        }
+        dump.objects_.push_back(std::move(obj));
+    }
+    return dump;
+}
+
+
+std::vector<uint64_t> yapvm::ygc::HeapDump::retained_sizes() const {
+    // Cooper, Harvey, Kennedy iterative dominators, virtual root references all roots
+    constexpr size_t UNDEF = SIZE_MAX;
+    size_t n = objects_.size();
+    size_t root = n;
+    auto successors = [&](size_t v) -> const std::vector<uint64_t> & {
+        return v == root ? roots_ : objects_[v].edges_;
+    };
+
+    std::vector<size_t> postorder;
+    std::vector<size_t> post_num(n + 1, UNDEF);
+    std::vector<bool> visited(n + 1, false);
+    std::vector<std::pair<size_t, size_t>> dfs{ { root, 0 } };
+    visited[root] = true;
+    while (!dfs.empty()) {
+        auto &[v, next] = dfs.back();
+        const std::vector<uint64_t> &succ = successors(v);
+        if (next < succ.size()) {
+            size_t w = succ[next++];
+            if (!visited[w]) {
+                visited[w] = true;
+                dfs.emplace_back(w, 0);
+            }
+            continue;
+        }
+        post_num[v] = postorder.size();
+        postorder.push_back(v);
+        dfs.pop_back();
+    }
+
+    std::vector<std::vector<size_t>> preds(n + 1);
+    for (size_t v : postorder) {
+        for (uint64_t w : successors(v)) {
+            preds[w].push_back(v);
+        }
+    }
+
+    std::vector<size_t> idom(n + 1, UNDEF);
+    idom[root] = root;
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (post_num[a] < post_num[b]) {
+                a = idom[a];
+            }
+            while (post_num[b] < post_num[a]) {
+                b = idom[b];
+            }
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // reverse postorder, root is the last one
+        for (size_t k = postorder.size() - 1; k-- > 0;) {
+            size_t v = postorder[k];
+            size_t new_idom = UNDEF;
+            for (size_t p : preds[v]) {
+                if (idom[p] != UNDEF) {
+                    new_idom = new_idom == UNDEF ? p : intersect(p, new_idom);
+                }
+            }
+            if (idom[v] != new_idom) {
+                idom[v] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // dominator is finished later than objects it dominates
+    std::vector<uint64_t> retained(n + 1, 0);
+    for (size_t v = 0; v < n; v++) {
+        retained[v] = objects_[v].size_;
+    }
+    for (size_t k = 0; k + 1 < postorder.size(); k++) {
+        size_t v = postorder[k];
+        retained[idom[v]] += retained[v];
+    }
+    retained.pop_back();
+    return retained;
+}
+
+
+std::string yapvm::ygc::HeapDump::summary(size_t top) const {
+    auto type_name = [&](uint32_t id) {
+        auto it = type_names_.find(id);
+        return it != type_names_.end() ? it->second : "<type " + std::to_string(id) + ">";
+    };
+
+    struct TypeTotal {
+        uint32_t id_;
+        size_t count_ = 0;
+        uint64_t bytes_ = 0;
+    };
+    std::map<uint32_t, TypeTotal> per_type;
+    uint64_t bytes = 0;
+    for (const Object &obj : objects_) {
+        TypeTotal &total = per_type[obj.type_id_];
+        total.id_ = obj.type_id_;
+        total.count_++;
+        total.bytes_ += obj.size_;
+        bytes += obj.size_;
+    }
+    std::vector<TypeTotal> types;
+    for (const auto &[id, total] : per_type) {
+        types.push_back(total);
+    }
+    std::sort(types.begin(), types.end(), [](const TypeTotal &a, const TypeTotal &b) { return a.bytes_ > b.bytes_; });
+
+    std::ostringstream out;
+    out << objects_.size() << " objects, " << bytes << " bytes, " << roots_.size() << " roots\n\n";
+    out << "per type:\n" << std::setw(12) << "count" << std::setw(14) << "bytes" << "  type\n";
+    for (const TypeTotal &t : types) {
+        out << std::setw(12) << t.count_ << std::setw(14) << t.bytes_ << "  " << type_name(t.id_) << '\n';
+    }
+
+    std::vector<uint64_t> retained = retained_sizes();
+    std::vector<size_t> order(objects_.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    top = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(top), order.end(),
+                      [&](size_t a, size_t b) { return retained[a] > retained[b]; });
+    out << "\ntop retainers:\n" << std::setw(14) << "retained" << std::setw(12) << "shallow" << std::setw(10)
+        << "edges" << "  object\n";
+    for (size_t k = 0; k < top; k++) {
+        const Object &obj = objects_[order[k]];
+        out << std::setw(14) << retained[order[k]] << std::setw(12) << obj.size_ << std::setw(10) << obj.edges_.size()
+            << "  #" << order[k] << ' ' << type_name(obj.type_id_) << '\n';
+    }
+    return out.str();
+}
@@ -0,0 +1,24 @@
+#include <iostream>
+#include <string>
+
+#include "heap_dump.h"
+
+using namespace yapvm::ygc;
+
+
+// offline summary of dump written by yapvm -Xheapdump
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        std::cout << "Usage: yapvm_heap_summary <heap dump> [top retainers count]" << std::endl;
+        return 1;
+    }
+    size_t top = argc == 3 ? std::stoul(argv[2]) : 20;
+
+    try {
+        std::cout << HeapDump::read(argv[1]).summary(top);
+    } catch (const std::runtime_error &e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -10,30 +10,21 @@
 #include "interpreter.h"
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
 
+#include "compiler.h"
 #include "logger.h"
 
 static std::atomic_size_t GLOBAL_BORN_THREAD_ID = 71;
 
-// TODO rewrite as Scope method
-#define LAST_EXEC_RES_YOBJ static_cast<ManagedObject *>(scope_->get(Scope::lst_exec_res).value().value_)->value()
-#define LAST_EXEC_RES_M_YOBJ static_cast<ManagedObject *>(scope_->get(Scope::lst_exec_res).value().value_)
 
-#define LAST_EXEC_RES_YOBJ static_cast<ManagedObject *>(scope_->get(Scope::lst_exec_res).value().value_)->value()
 
-//TODO use condvars for wait
-
-
-void yapvm::interpreter::Interpreter::handle_safepoint() {
-    if (need_park_.load()) {
-        parked_.store(true);
-        need_park_.store(false);
-        while (!need_unpark_.load()) {
-            std::this_thread::sleep_for(std::chrono::microseconds(50));
-        }
-        parked_.store(false);
-        need_unpark_.store(false);
-    }
+// parked interpreter sleeps in thread manager until gc resumes the world
+void yapvm::interpreter::Interpreter::park_at_safepoint() {
+    need_park_.store(false, std::memory_order_relaxed);
+    parked_.store(true);
+    thread_manager_->block_at_safepoint();
+    parked_.store(false);
 }
 
 
@@ -48,728 +39,891 @@ std::vector<yapvm::scoped_ptr<Stmt>> copy_vec_no_owning(const std::vector<yapvm:
 }
 
 
+// semantics of operators, shared by ast interpreter and bytecode dispatch loop
+// heap results are not registered in gc, caller should do it
+// tm is needed to let gc stop the world while long string repetition runs
+static
+yapvm::yobjects::Value eval_binary(yapvm::bytecode::BinaryOperator op, Value left, Value right, yapvm::interpreter::ThreadManager *tm) {
+    using namespace yapvm::bytecode;
+
+    if (left.get_typename_id() != right.get_typename_id() && left.get_type() != YType::String) {
+        throw std::runtime_error("Interpreter: BinOp operands currently need to be same type");
+    }
+
+    YType type = left.get_type();
+    switch (op) {
+        case BINARY_ADD:
+            if (type == YType::Bool) {
+                return Value::from_int(static_cast<ssize_t>(left.get_value_as_bool()) + static_cast<ssize_t>(right.get_value_as_bool()));
+            }
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() + right.get_value_as_int());
+            }
+            if (type == YType::Float) {
+                return Value::from_float(left.get_value_as_float() + right.get_value_as_float());
+            }
+            if (type == YType::String) {
+                if (right.get_type() != YType::String) {
+                    throw std::runtime_error("Interpreter: Add for string require string as right argument");
+                }
+                return new ManagedObject{ constr_ystring(left.yobject()->get_value_as_string() + right.yobject()->get_value_as_string()) };
+            }
+            throw std::runtime_error("Interpreter: Add not supported for " + left.get_typename());
+        case BINARY_SUB:
+            if (type == YType::Bool) {
+                return Value::from_int(static_cast<ssize_t>(left.get_value_as_bool()) - static_cast<ssize_t>(right.get_value_as_bool()));
+            }
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() - right.get_value_as_int());
+            }
+            if (type == YType::Float) {
+                return Value::from_float(left.get_value_as_float() - right.get_value_as_float());
+            }
+            throw std::runtime_error("Interpreter: Sub not supported for " + left.get_typename());
+        case BINARY_MULT:
+            if (type == YType::Bool) {
+                return Value::from_int(left.get_value_as_bool() && right.get_value_as_bool() ? 1 : 0);
+            }
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() * right.get_value_as_int());
+            }
+            if (type == YType::Float) {
+                return Value::from_float(left.get_value_as_float() * right.get_value_as_float());
+            }
+            if (type == YType::String) {
+                if (right.get_type() != YType::Int) {
+                    throw std::runtime_error("Interpreter: Mult for string require int as right argument");
+                }
+                std::string base = left.yobject()->get_value_as_string();
+                ssize_t times = right.get_value_as_int();
+                std::string res;
+                {
+                    yapvm::interpreter::SafeRegion safe_region{ tm }; // operands are not used since base is copied
+                    if (times > 0) {
+                        res.reserve(base.size() * static_cast<size_t>(times));
+                    }
+                    for (ssize_t i = 0; i < times; i++) {
+                        res += base;
+                    }
+                }
+                return new ManagedObject{ constr_ystring(std::move(res)) };
+            }
+            throw std::runtime_error("Interpreter: Mult not supported for " + left.get_typename());
+        case BINARY_DIV:
+            if (type == YType::Int) {
+                return Value::from_float(static_cast<double>(left.get_value_as_int()) / static_cast<double>(right.get_value_as_int()));
+            }
+            if (type == YType::Float) {
+                return Value::from_float(left.get_value_as_float() / right.get_value_as_float());
+            }
+            throw std::runtime_error("Interpreter: Div not supported for " + left.get_typename());
+        case BINARY_MOD:
+            if (type == YType::Bool) {
+                return Value::from_int(left.get_value_as_bool() && right.get_value_as_bool() ? 1 : 0);
+            }
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() % right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: Mod not supported for " + left.get_typename());
+        case BINARY_POW:
+            if (type == YType::Bool) {
+                return Value::from_int(left.get_value_as_bool() && right.get_value_as_bool() ? 1 : 0);
+            }
+            if (type == YType::Int) {
+                return Value::from_int(static_cast<ssize_t>(std::pow(left.get_value_as_int(), right.get_value_as_int())));
+            }
+            if (type == YType::Float) {
+                return Value::from_float(std::pow(left.get_value_as_float(), right.get_value_as_float()));
+            }
+            throw std::runtime_error("Interpreter: Pow not supported for " + left.get_typename());
+        case BINARY_LSHIFT:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() << right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: LShift not supported for " + left.get_typename());
+        case BINARY_RSHIFT:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() >> right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: RShift not supported for " + left.get_typename());
+        case BINARY_BITOR:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() | right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: BitOr not supported for " + left.get_typename());
+        case BINARY_BITXOR:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() ^ right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: BitXor not supported for " + left.get_typename());
+        case BINARY_BITAND:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() & right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: BitAnd not supported for " + left.get_typename());
+        case BINARY_FLOORDIV:
+            if (type == YType::Int) {
+                return Value::from_int(left.get_value_as_int() / right.get_value_as_int());
+            }
+            throw std::runtime_error("Interpreter: FloorDiv not supported for " + left.get_typename());
+    }
+    throw std::runtime_error("Interpreter: unexpected BinaryOperatorKind");
+}
+
+
+static
+yapvm::yobjects::Value eval_unary(yapvm::bytecode::UnaryOperator op, Value operand) {
+    using namespace yapvm::bytecode;
+
+    YType type = operand.get_type();
+    switch (op) {
+        case UNARY_NOT:
+            if (type == YType::Bool) {
+                return Value::from_bool(!operand.get_value_as_bool());
+            }
+            throw std::runtime_error("Interpreter: Not not supported for " + operand.get_typename());
+        case UNARY_USUB:
+            if (type == YType::Int) {
+                return Value::from_int(-operand.get_value_as_int());
+            }
+            if (type == YType::Float) {
+                return Value::from_float(-operand.get_value_as_float());
+            }
+            throw std::runtime_error("Interpreter: USub not supported for " + operand.get_typename());
+        default:
+            break;
+    }
+    throw std::runtime_error("Interpreter: unexpected UnaryOpKind");
+}
+
+
+template <typename T>
+static bool compare_values(yapvm::bytecode::CompareOperator op, const T &left, const T &right) {
+    using namespace yapvm::bytecode;
+
+    switch (op) {
+        case CMP_EQ: return left == right;
+        case CMP_NOTEQ: return left != right;
+        case CMP_LT: return left < right;
+        case CMP_LTE: return left <= right;
+        case CMP_GT: return left > right;
+        case CMP_GTE: return left >= right;
+        default:
+            break;
+    }
+    throw std::runtime_error("Interpteter: unexpected CmpOpKind");
+}
+
+
+static
+yapvm::yobjects::Value eval_compare(yapvm::bytecode::CompareOperator op, Value left, Value right) {
+    using namespace yapvm::bytecode;
+
+    if (op > CMP_GTE) {
+        throw std::runtime_error("Interpteter: unexpected CmpOpKind");
+    }
+    if (left.get_typename_id() != right.get_typename_id()) {
+        return Value::from_bool(false);
+    }
+
+    // TODO special handle for lists, dicts???
+    YType type = left.get_type();
+    bool result;
+    if (type == YType::Bool) {
+        result = compare_values(op, left.get_value_as_bool(), right.get_value_as_bool());
+    } else if (type == YType::Int) {
+        result = compare_values(op, left.get_value_as_int(), right.get_value_as_int());
+    } else if (type == YType::Float) {
+        result = compare_values(op, left.get_value_as_float(), right.get_value_as_float());
+    } else if (type == YType::String) {
+        result = compare_values(op, left.yobject()->get_value_as_string(), right.yobject()->get_value_as_string());
+    } else if (op == CMP_EQ) {
+        result = left == right;
+    } else if (op == CMP_NOTEQ) {
+        result = left != right;
+    } else {
+        static const char *names[] = { "Eq", "NotEq", "Lt", "LtE", "Gt", "GtE" };
+        throw std::runtime_error(std::string{ "Interpreter: " } + names[op] + " not supported for " + left.get_typename());
+    }
+    return Value::from_bool(result);
+}
+
+
+static
+yapvm::yobjects::Value eval_convert(yapvm::bytecode::Conversion conv, Value arg) {
+    using namespace yapvm::bytecode;
+
+    YType type = arg.get_type();
+    switch (conv) {
+        case CONV_STR:
+            if (type == YType::String) {
+                return new ManagedObject{ constr_ystring(arg.yobject()->get_value_as_string()) };
+            }
+            if (type == YType::Int) {
+                return new ManagedObject{ constr_ystring(std::to_string(arg.get_value_as_int())) };
+            }
+            if (type == YType::Float) {
+                return new ManagedObject{ constr_ystring(std::to_string(arg.get_value_as_float())) };
+            }
+            if (type == YType::Bool) {
+                return new ManagedObject{ constr_ystring(arg.get_value_as_bool() ? "True" : "False") };
+            }
+            throw std::runtime_error("Interpreter: cannot construct string from " + arg.get_typename());
+        case CONV_INT:
+            if (type == YType::String) {
+                return Value::from_int(yapvm::from_str<ssize_t>(arg.yobject()->get_value_as_string()));
+            }
+            if (type == YType::Int) {
+                return Value::from_int(arg.get_value_as_int());
+            }
+            if (type == YType::Float) {
+                return Value::from_int(static_cast<ssize_t>(arg.get_value_as_float()));
+            }
+            if (type == YType::Bool) {
+                return Value::from_int(arg.get_value_as_bool() ? 1 : 0);
+            }
+            throw std::runtime_error("Interpreter: cannot construct int from " + arg.get_typename());
+        case CONV_FLOAT:
+            if (type == YType::String) {
+                return Value::from_float(yapvm::from_str<double>(arg.yobject()->get_value_as_string()));
+            }
+            if (type == YType::Int) {
+                return Value::from_float(static_cast<double>(arg.get_value_as_int()));
+            }
+            if (type == YType::Float) {
+                return Value::from_float(arg.get_value_as_float());
+            }
+            throw std::runtime_error("Interpreter: cannot construct float from " + arg.get_typename());
+    }
+    throw std::runtime_error("Interpreter: unexpected conversion");
+}
+
+
+// negative key counts from the end of list, same as in python
+static size_t list_index(Value list, ssize_t key) {
+    ssize_t len = static_cast<ssize_t>(list.yobject()->get_len_as_list());
+    if (key >= len || key < -len) {
+        throw std::runtime_error("Interpreter: list index out of range");
+    }
+    return static_cast<size_t>(key < 0 ? len + key : key);
+}
+
+
+static
+yapvm::yobjects::Value subscript_load(Value value, Value key) {
+    if (value.get_type() != YType::List) {
+        throw std::runtime_error("Interpreter: Subscript currently supported only for lists");
+    }
+    if (key.get_type() != YType::Int) {
+        throw std::runtime_error("Interpreter: Subscript key for list should be int");
+    }
+
+    return value.yobject()->get_list_element(list_index(value, key.get_value_as_int()));
+}
+
+
 // SHOULD be called only once when interpreter starts
 void yapvm::interpreter::Interpreter::__worker_exec(Module *code) {
     //Logger::log("starting interpreter");
+    memory::set_current_allocator(&tlab_);
 
-    for (const scoped_ptr<Stmt> &i: code->body()) {
-        if (!interpret(i)) {
-            break;
-        }
-        if (finishing_.load()) {
-            break;
+    try {
+        if (program_) {
+            exec_code(entry_);
+        } else {
+            for (const scoped_ptr<Stmt> &i: code->body()) {
+                if (!interpret(i)) {
+                    break;
+                }
+                if (finishing_.load()) {
+                    break;
+                }
+            }
         }
+    } catch (const memory::OutOfMemory &e) {
+        // language has no exceptions, so whole vm is stopped with error instead of terminate from thread
+        Logger::log("Interpreter", e.what());
+        std::cout.flush();
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::quick_exit(1);
     }
+    tlab_.retire();
+    memory::set_current_allocator(nullptr);
+    bytecode::add_call_cache_stats(call_cache_stats_);
+    main_scope_->set_thread_root(false); // scope stays in parent scope, parent visits it from now
     while (!thread_manager_->unregister_interpreter(this)) {
         handle_safepoint();
     }
+    memory::Heap::instance().wake_gc(); // gc may be idle, it finishes when no interpreters are left
 }
 
 
-// TODO all variables accesses should be uprising lookups
-void yapvm::interpreter::Interpreter::interpret_expr(Expr *code) {
-    //TODO after every expr exec change lst_expr_res
-    if (instanceof<BoolOp>(code)) {
-        BoolOp *bool_op = dynamic_cast<BoolOp *>(code);
-        interpret_expr(bool_op->values()[0]);
-
-        YObject *first_call_res = LAST_EXEC_RES_YOBJ;
-        if (first_call_res->get_typename() != "bool") {
-            throw std::runtime_error("Interpreter: BoolOp args should be bools in end of evaluation");
+yapvm::yobjects::Value yapvm::interpreter::Interpreter::spawn_thread(FunctionDef *callee, Value arg) {
+    size_t id;
+    do {
+        id = GLOBAL_BORN_THREAD_ID.load();
+    } while (!GLOBAL_BORN_THREAD_ID.compare_exchange_strong(id, id + 1));
+    std::string thread_name = Scope::scope_entry_thread_name(id);
+
+    scope_->change(thread_name, ScopeEntry{ new Scope{scope_}, SCOPE });
+    Scope *thread_scope = static_cast<Scope *>(scope_->get(thread_name).value().value_);
+    Interpreter *thread;
+    if (program_) {
+        const bytecode::CodeObject *entry = program_->function_code(callee);
+        thread_scope->bind_slots(&entry->locals_);
+        thread_scope->change(callee->args()[0], ScopeEntry{ nullptr, OBJECT, arg });
+        thread = new Interpreter{ program_.get(), entry, thread_manager_, thread_scope };
+    } else {
+        thread_scope->change(callee->args()[0], ScopeEntry{ nullptr, OBJECT, arg });
+        thread = new Interpreter{
+            new Module{ copy_vec_no_owning(callee->body()) }, thread_manager_, thread_scope, TREE_WALKER
+        };
+    }
+    thread->launch(this);
+
+    Logger::log("Interpreter",
+        "created and launched new thread with interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(thread))
+        + "] from interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(this))
+        + "]"
+    );
+    return Value::from_int(static_cast<ssize_t>(reinterpret_cast<size_t>(thread)));
+}
+
+
+void yapvm::interpreter::Interpreter::join_thread(Value thread_object) {
+    if (thread_object.get_type() != YType::Int) {
+        throw std::runtime_error("Interpreter: unrecognized thread object");
+    }
+    Interpreter *thread = reinterpret_cast<Interpreter *>(
+        static_cast<size_t>(thread_object.get_value_as_int())
+    );
+
+    Logger::log("Interpreter",
+        "waiting to join thread with interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(thread))
+        + "] from interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(this))
+        + "]"
+    );
+    std::optional<bool> is_thread_registered_opt = thread_manager_->is_registered(thread);
+    while (true) {
+        if (is_thread_registered_opt.has_value()) {
+            if (!is_thread_registered_opt.value()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
         }
-        bool result = first_call_res->get_value_as_bool();
+        is_thread_registered_opt = thread_manager_->is_registered(thread);
+        handle_safepoint();
+    }
+    while (!thread_manager_->finish_waiting()) {
+        handle_safepoint();
+    }
+    handle_safepoint();
+    Logger::log("Interpreter",
+        "joined thread with interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(thread))
+        + "] from interpreter ["
+        + std::to_string(reinterpret_cast<size_t>(this))
+        + "]"
+    );
+}
+
 
-        for (size_t i = 1; i < bool_op->values().size(); i++) {
-            interpret_expr(bool_op->values()[i]);
-            YObject *call_res = LAST_EXEC_RES_YOBJ;
-            if (call_res->get_typename() != "bool") {
-                throw std::runtime_error("Interpreter: BoolOp args should be bools in end of evaluation");
+// bytecode dispatch loop, every call of user function is new exec_code frame
+// with its own pc on top of shared operand stack
+yapvm::yobjects::Value yapvm::interpreter::Interpreter::exec_code(const bytecode::CodeObject *code) {
+    using namespace yapvm::bytecode;
+
+    const Instruction *instrs = code->code_.data();
+    Value *slots = frame_ != nullptr ? frame_->slots() : scope_->slots();
+    size_t pc = 0;
+    while (true) {
+        const Instruction &ins = instrs[pc++];
+        switch (ins.op_) {
+            case OP_NOP:
+                break;
+            case OP_SAFEPOINT:
+                handle_safepoint();
+                break;
+            case OP_LOAD_CONST:
+                stack_.push_back(code->consts_[ins.arg_]);
+                break;
+            case OP_LOAD_NAME: {
+                Symbol name = code->names_[ins.arg_];
+                ScopeEntry n_sce = name_lookup(name);
+                if (n_sce.type_ != OBJECT) {
+                    throw std::runtime_error("Interpreter: " + name.str() + " is not name of object");
+                }
+                stack_.push_back(n_sce.object_);
+                break;
             }
-            if (dynamic_cast<And *>(bool_op->op().get()) != nullptr) {
-                result = result && call_res->get_value_as_bool();
-            } else {
-                result = result || call_res->get_value_as_bool();
+            case OP_LOAD_FAST: {
+                Value value = slots[ins.arg_];
+                if (Scope::is_unbound(value)) [[unlikely]] {
+                    // not assigned in this frame yet, so it is still a free name
+                    Symbol name = code->locals_.names_[ins.arg_];
+                    ScopeEntry n_sce = name_lookup(name);
+                    if (n_sce.type_ != OBJECT) {
+                        throw std::runtime_error("Interpreter: " + name.str() + " is not name of object");
+                    }
+                    value = n_sce.object_;
+                }
+                stack_.push_back(value);
+                break;
             }
-        }
+            case OP_STORE_FAST:
+                slots[ins.arg_] = stack_.back();
+                stack_.pop_back();
+                break;
+            case OP_POP:
+                stack_.pop_back();
+                break;
+            case OP_BINARY: {
+                Value resobj = eval_binary(static_cast<BinaryOperator>(ins.arg_), stack_[stack_.size() - 2], stack_.back(), thread_manager_);
+                register_value(resobj);
+                stack_.pop_back();
+                stack_.back() = resobj;
+                break;
+            }
+            case OP_UNARY: {
+                Value resobj = eval_unary(static_cast<UnaryOperator>(ins.arg_), stack_.back());
+                register_value(resobj);
+                stack_.back() = resobj;
+                break;
+            }
+            case OP_COMPARE: {
+                Value resobj = eval_compare(static_cast<CompareOperator>(ins.arg_), stack_[stack_.size() - 2], stack_.back());
+                stack_.pop_back();
+                stack_.back() = resobj;
+                break;
+            }
+            case OP_BOOL_AND:
+            case OP_BOOL_OR: {
+                // all values are evaluated, same as in ast interpreter
+                bool result = ins.op_ == OP_BOOL_AND;
+                for (size_t i = stack_.size() - ins.arg_; i < stack_.size(); i++) {
+                    const Value &value = stack_[i];
+                    if (value.get_type() != YType::Bool) {
+                        throw std::runtime_error("Interpreter: BoolOp args should be bools in end of evaluation");
+                    }
+                    if (ins.op_ == OP_BOOL_AND) {
+                        result = result && value.get_value_as_bool();
+                    } else {
+                        result = result || value.get_value_as_bool();
+                    }
+                }
+                stack_.resize(stack_.size() - ins.arg_);
+                stack_.push_back(Value::from_bool(result));
+                break;
+            }
+            case OP_JUMP:
+                pc = ins.arg_;
+                break;
+            case OP_POP_JUMP_IF_FALSE: {
+                Value test_res = stack_.back();
+                if (test_res.get_type() != YType::Bool) {
+                    throw std::runtime_error("Interpreter: test expression should be bool");
+                }
+                stack_.pop_back();
+                if (!test_res.get_value_as_bool()) {
+                    pc = ins.arg_;
+                }
+                break;
+            }
+            case OP_LOAD_SUBSCR: {
+                Value element = subscript_load(stack_[stack_.size() - 2], stack_.back());
+                stack_.pop_back();
+                stack_.back() = element;
+                break;
+            }
+            case OP_STORE_SUBSCR: {
+                Value value = stack_[stack_.size() - 3];
+                if (value.get_type() != YType::List) {
+                    throw std::runtime_error("Interpreter: currently can assign only to list subscript");
+                }
+                Value key = stack_[stack_.size() - 2];
+                if (key.get_type() != YType::Int) {
+                    throw std::runtime_error("Interpreter: list subscript key should be int");
+                }
+                value.object()->set_list_element(list_index(value, key.get_value_as_int()), stack_.back());
+                stack_.resize(stack_.size() - 3);
+                break;
+            }
+            case OP_LIST_APPEND: {
+                Value target = stack_[stack_.size() - 2];
+                if (target.get_type() != YType::List) {
+                    throw std::runtime_error("Interpreter: Currently only list attributes");
+                }
+                target.object()->add_list_element(stack_.back());
+                stack_[stack_.size() - 2] = stack_.back();
+                stack_.pop_back();
+                break;
+            }
+            case OP_INPLACE_ADD: {
+                Value target = stack_[stack_.size() - 2];
+                if (target.get_type() != YType::List) {
+                    throw std::runtime_error("Interpreter: currently AugAssign supported only for lists");
+                }
+                target.object()->add_list_element(stack_.back());
+                stack_.resize(stack_.size() - 2);
+                break;
+            }
+            case OP_BUILD_LIST: {
+                ManagedObject *resobj = new ManagedObject{ constr_ylist() };
+                register_value(resobj);
+                stack_.push_back(resobj);
+                break;
+            }
+            case OP_PRINT: {
+                Value print_arg = stack_.back();
+                if (print_arg.get_type() != YType::String) {
+                    throw std::runtime_error("Interpreter: print argument should be string");
+                }
+                std::cout << print_arg.yobject()->get_value_as_string();
+                break;
+            }
+            case OP_CONVERT: {
+                Value resobj = eval_convert(static_cast<Conversion>(ins.arg_), stack_.back());
+                register_value(resobj);
+                stack_.back() = resobj;
+                break;
+            }
+            case OP_MAKE_FUNCTION: {
+                FunctionDef *fdef = const_cast<FunctionDef *>(code->functions_[ins.arg_]);
+                if (frame_ != nullptr && frame_->dynamic_ == nullptr) {
+                    dynamic_frames_++;
+                }
+                Scope *defined_in = frame_ != nullptr ? frame_->dynamic_scope() : scope_;
+                defined_in->change(Scope::scope_entry_function_name(fdef->name()), ScopeEntry{ fdef, FUNCTION });
+                break;
+            }
+            case OP_CALL: {
+                const CallSite &site = code->call_sites_[ins.arg_];
+                FunctionDef *function_def = resolve_callee(code, ins.arg_);
+                if (function_def == nullptr) {
+                    throw std::runtime_error("Interpreter: " + code->names_[site.name_].str() + " is not name of function");
+                }
+                if (site.argc_ != function_def->args().size()) {
+                    throw std::runtime_error("Interpreter: invalid number of arguments for function " + function_def->name());
+                }
 
-        ManagedObject *resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } }};
-        register_queue_.push(resobj);
-        scope_->update_last_exec_res(resobj);
-        return;
-    }
-    if (instanceof<BinOp>(code)) {
-        BinOp *bin_op = dynamic_cast<BinOp *>(code);
-        interpret_expr(bin_op->left());
-        // we have guarantees that GC will not happen here because it can happen only after single statement execution
-        YObject *left = LAST_EXEC_RES_YOBJ;
-        interpret_expr(bin_op->right());
-        YObject *right = LAST_EXEC_RES_YOBJ;
-
-        if (left->get_typename() != right->get_typename() && left->get_typename() != "string") {
-            throw std::runtime_error("Interpreter: BinOp operands currently need to be same type");
-        }
+                const CodeObject *callee_code = program_->function_code(function_def);
+                Frame *frame = frames_.push(callee_code, frame_);
+                size_t args_begin = stack_.size() - site.argc_;
+                std::copy(stack_.begin() + static_cast<ssize_t>(args_begin), stack_.end(), frame->slots()); // args take first slots
+                stack_.resize(args_begin);
+
+                frame_ = frame;
+                Value result = exec_code(callee_code);
+                frame_ = frame->caller_;
+                if (frame->dynamic_ != nullptr) {
+                    dynamic_frames_--;
+                }
+                frames_.pop(frame);
 
-        BinOpKind *op_kind = bin_op->op();
-        ManagedObject *resobj = nullptr;
-        if (instanceof<Add>(op_kind)) {
-            if (left->get_typename() == "bool") {
-                ssize_t res = 0;
-                if (left->get_value_as_bool()) {
-                    res++;
-                }
-                if (right->get_value_as_bool()) {
-                    res++;
-                }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res += right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "float") {
-                double res = 0;
-                res += left->get_value_as_float();
-                res += right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else if (left->get_typename() == "string") {
-                std::string res;
-                res += left->get_value_as_string();
-                res += right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{ std::move(res) } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Add not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Sub>(op_kind)) {
-            if (left->get_typename() == "bool") {
-                ssize_t res = 0;
-                if (left->get_value_as_bool()) {
-                    res++;
-                }
-                if (right->get_value_as_bool()) {
-                    res--;
-                }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res -= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "float") {
-                double res = 0;
-                res += left->get_value_as_float();
-                res -= right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Sub not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Mult>(op_kind)) {
-            if (left->get_typename() == "bool") {
-                ssize_t res = 0;
-                if (left->get_value_as_bool() && right->get_value_as_bool()) {
-                    res = 1;
-                }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res *= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "float") {
-                double res = 0;
-                res += left->get_value_as_float();
-                res *= right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else if (left->get_typename() == "string") {
-                std::string res;
-                if (right->get_typename() != "int") {
-                    throw std::runtime_error("Interpreter: Mult for string require int as right argument");
+                stack_.push_back(result); // no safepoint since return, so result needs no other root
+                break;
+            }
+            case OP_THREAD_SPAWN: {
+                const CallSite &site = code->call_sites_[ins.arg_];
+                FunctionDef *callee = resolve_callee(code, ins.arg_);
+                if (callee == nullptr) {
+                    throw std::runtime_error("Interpreterer: cannot find function " + code->names_[site.name_].str());
+                }
+                if (callee->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: thread callee should have only one argument");
                 }
-                std::string base = left->get_value_as_string();
-                ssize_t times = right->get_value_as_int();
-                for (size_t i = 0; i < times; i++) {
-                    res += base;
-                }
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{ std::move(res) } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Mult not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Div>(op_kind)) {
-            if (left->get_typename() == "int") {
-                double res = 0;
-                res += static_cast<double>(left->get_value_as_int());
-                res /= static_cast<double>(right->get_value_as_int());
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else if (left->get_typename() == "float") {
-                double res = 0;
-                res += left->get_value_as_float();
-                res /= right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Div not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Mod>(op_kind)) {
-            if (left->get_typename() == "bool") {
-                ssize_t res = 0;
-                if (left->get_value_as_bool() && right->get_value_as_bool()) {
-                    res = 1;
-                }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res %= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Mod not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Pow>(op_kind)) {
-            if (left->get_typename() == "bool") {
-                ssize_t res = 0;
-                if (left->get_value_as_bool() && right->get_value_as_bool()) {
-                    res = 1;
-                }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res = static_cast<ssize_t>(std::pow(res, right->get_value_as_int()));
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else if (left->get_typename() == "float") {
-                double res = 0;
-                res += left->get_value_as_float();
-                res = std::pow(res, right->get_value_as_float());
-                resobj = new ManagedObject{ new YObject{ "float", new double{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: Pow not supported for " + left->get_typename());
-            }
-        } else if (instanceof<LShift>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res <<= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: LShift not supported for " + left->get_typename());
-            }
-        } else if (instanceof<RShift>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res >>= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: RShift not supported for " + left->get_typename());
-            }
-        } else if (instanceof<BitOr>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res |= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: BitOr not supported for " + left->get_typename());
-            }
-        } else if (instanceof<BitXor>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res ^= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: BitXor not supported for " + left->get_typename());
-            }
-        } else if (instanceof<BitAnd>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res &= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: BitAnd not supported for " + left->get_typename());
-            }
-        } else if (instanceof<FloorDiv>(op_kind)) {
-            if (left->get_typename() == "int") {
-                ssize_t res = 0;
-                res += left->get_value_as_int();
-                res /= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ res } } };
-            } else { //TODO
-                throw std::runtime_error("Interpreter: BitAnd not supported for " + left->get_typename());
+
+                stack_.back() = spawn_thread(callee, stack_.back());
+                break;
             }
-        }
-        if (resobj == nullptr) {
-            throw std::runtime_error("Interpreter: unexpected BinaryOperatorKind");
-        }
-        register_queue_.push(resobj);
-        scope_->update_last_exec_res(resobj);
-        return;
-    }
-    if (instanceof<UnaryOp>(code)) {
-        UnaryOp *unary_op = dynamic_cast<UnaryOp *>(code);
-        interpret_expr(unary_op->operand());
-        YObject *operand = LAST_EXEC_RES_YOBJ;
-
-        UnaryOpKind *op_kind = unary_op->op();
-        ManagedObject *resobj = nullptr;
-        if (instanceof<Not>(op_kind)) {
-            if (operand->get_typename() == "bool") {
-                bool value = !operand->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ value } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: Not not supported for " + operand->get_typename());
-            }
-        } else if (instanceof<USub>(op_kind)) {
-            if (operand->get_typename() == "int") {
-                ssize_t value = -operand->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ value } } };
-            } else if (operand->get_typename() == "float") {
-                double value = -operand->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "float", new double{ value } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: USub not supported for " + operand->get_typename());
+            case OP_THREAD_JOIN:
+                join_thread(stack_.back());
+                break;
+            case OP_RETURN_VALUE: {
+                Value result = stack_.back();
+                stack_.pop_back();
+                return result;
             }
+            case OP_RETURN_NONE:
+                return Value::none();
+            case OP_RAISE:
+                throw std::runtime_error(code->messages_[ins.arg_]);
         }
+    }
+}
 
-        if (resobj == nullptr) {
-            throw std::runtime_error("Interpreter: unexpected UnaryOpKind");
+
+yapvm::interpreter::ScopeEntry yapvm::interpreter::Interpreter::name_lookup(Symbol name) {
+    for (Frame *frame = frame_; frame != nullptr; frame = frame->caller_) {
+        if (std::optional<ScopeEntry> entry = frame->get(name); entry.has_value()) {
+            return entry.value();
         }
-        register_queue_.push(resobj);
-        scope_->update_last_exec_res(resobj);
-        return;
     }
-    if (instanceof<Compare>(code)) {
-        Compare *compare = dynamic_cast<Compare *>(code);
-        if (compare->comparators().size() != 1) {
-            throw std::runtime_error("Interpreter: Compare currently supported only with one argument");
-        }
-        interpret_expr(compare->left());
-        YObject *left = LAST_EXEC_RES_YOBJ;
-        CmpOpKind *op = compare->ops()[0];
-        interpret_expr(compare->comparators()[0]);
-        YObject *right = LAST_EXEC_RES_YOBJ;
-
-        if (left->get_typename() != right->get_typename()) {
-            ManagedObject *resobj = new ManagedObject{ new YObject{ "bool", new bool{ false } } };
-            scope_->update_last_exec_res(resobj);
-            return;
-        }
+    return scope_->name_lookup(name);
+}
 
-        // TODO special handle for lists, dicts???
-        ManagedObject *resobj = nullptr;
-        if (instanceof<Eq>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() == right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() == right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() == right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() == right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else {
-                bool result = left == right;
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            }
-        } else if (instanceof<NotEq>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() != right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() != right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() != right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() != right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else {
-                bool result = left != right;
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            }
-        } else if (instanceof<Lt>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() < right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() < right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() < right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() < right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: Lt not supported for " + left->get_typename());
-            }
-        } else if (instanceof<LtE>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() <= right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() <= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() <= right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() <= right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: LtE not supported for " + left->get_typename());
-            }
-        } else if (instanceof<Gt>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() > right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() > right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() > right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() > right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: Gt not supported for " + left->get_typename());
-            }
-        } else if (instanceof<GtE>(op)) {
-            if (left->get_typename() == "bool") {
-                bool result = left->get_value_as_bool() >= right->get_value_as_bool();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "int") {
-                bool result = left->get_value_as_int() >= right->get_value_as_int();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "float") {
-                bool result = left->get_value_as_float() >= right->get_value_as_float();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else if (left->get_typename() == "string") {
-                bool result = left->get_value_as_string() >= right->get_value_as_string();
-                resobj = new ManagedObject{ new YObject{ "bool", new bool{ result } } };
-            } else { // TODO
-                throw std::runtime_error("Interpreter: Gt not supported for " + left->get_typename());
-            }
-        }
-        if (resobj == nullptr) {
-            throw std::runtime_error("Interpteter: unexpected CmpOpKind");
-        }
-        register_queue_.push(resobj);
-        scope_->update_last_exec_res(resobj);
-        return;
+
+yapvm::ast::FunctionDef *yapvm::interpreter::Interpreter::resolve_callee(const bytecode::CodeObject *code, uint32_t site_idx) {
+    Symbol name = code->names_[code->call_sites_[site_idx].name_];
+    auto function_of = [](const ScopeEntry &sce) {
+        return sce.type_ == FUNCTION ? static_cast<FunctionDef *>(sce.value_) : nullptr;
+    };
+    if (dynamic_frames_ != 0) {
+        // nested functions of running calls may shadow cached ones
+        call_cache_stats_.misses_++;
+        return function_of(name_lookup(name));
     }
-    if (instanceof<Call>(code)) {
-        Call *call = dynamic_cast<Call *>(code);
-        if (!instanceof<Name>(call->func().get()) && !instanceof<Attribute>(call->func().get())) {
-            throw std::runtime_error("Interpreter: Call.func should be Name");
-        }
 
-        if (instanceof<Attribute>(call->func().get())) {
-            Attribute *attribute = dynamic_cast<Attribute *>(call->func().get());
-            interpret_expr(attribute->value());
-            YObject *target = LAST_EXEC_RES_YOBJ;
-            if (target->get_typename() != "list") {
-                throw std::runtime_error("Interpreter: Currently only list attributes");
-            }
+    bytecode::CallCache &cache = code->call_caches_[site_idx];
+    uint64_t epoch = Scope::functions_epoch();
+    bool polymorphic = false;
+    if (FunctionDef *callee = cache.find(scope_->id(), epoch, polymorphic); callee != nullptr) {
+        (polymorphic ? call_cache_stats_.polymorphic_ : call_cache_stats_.monomorphic_)++;
+        return callee;
+    }
+    call_cache_stats_.misses_++;
+    FunctionDef *callee = function_of(name_lookup(name));
+    if (callee != nullptr) {
+        cache.insert(scope_->id(), callee, epoch);
+    }
+    return callee;
+}
 
-            std::string attr = attribute->attr();
-            if (attr != "append") {
-                throw std::runtime_error("Interpreter: Currently supported only list.append as attribute");
-            }
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: list.append require 1 argument");
+
+// TODO all variables accesses should be uprising lookups
+void yapvm::interpreter::Interpreter::interpret_expr(Expr *code) {
+    switch (code->kind()) {
+        case NodeKind::BoolOp: {
+            BoolOp *bool_op = static_cast<BoolOp *>(code);
+            size_t values_base = stack_.size();
+            for (Expr *e : bool_op->values()) {
+                interpret_expr(e);
             }
-            interpret_expr(call->args()[0]);
 
-            ManagedObject *arg = LAST_EXEC_RES_M_YOBJ;
-            target->add_list_element(arg);
+            bool result = bool_op->op()->kind() == NodeKind::And;
+            for (size_t i = values_base; i < stack_.size(); i++) {
+                const Value &value = stack_[i];
+                if (value.get_type() != YType::Bool) {
+                    throw std::runtime_error("Interpreter: BoolOp args should be bools in end of evaluation");
+                }
+                if (bool_op->op()->kind() == NodeKind::And) {
+                    result = result && value.get_value_as_bool();
+                } else {
+                    result = result || value.get_value_as_bool();
+                }
+            }
+            stack_.resize(values_base);
+            stack_.push_back(Value::from_bool(result));
+            return;
+        }
+        case NodeKind::BinOp: {
+            BinOp *bin_op = static_cast<BinOp *>(code);
+            interpret_expr(bin_op->left());
+            interpret_expr(bin_op->right());
+
+            Value resobj = eval_binary(bytecode::binary_operator(bin_op->op()), stack_[stack_.size() - 2], stack_.back(), thread_manager_);
+            register_value(resobj);
+            stack_.pop_back();
+            stack_.back() = resobj;
             return;
         }
+        case NodeKind::UnaryOp: {
+            UnaryOp *unary_op = static_cast<UnaryOp *>(code);
+            interpret_expr(unary_op->operand());
 
-        std::string func_name = dynamic_cast<Name *>(call->func().get())->id();
-        if (func_name == "print") {
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: print can take only 1 argument");
-            }
-            interpret_expr(call->args()[0]);
-            YObject *print_arg = LAST_EXEC_RES_YOBJ;
-            if (print_arg->get_typename() != "string") {
-                throw std::runtime_error("Interpreter: print argument should be string");
-            }
-            std::cout << print_arg->get_value_as_string();
+            Value resobj = eval_unary(bytecode::unary_operator(unary_op->op()), stack_.back());
+            register_value(resobj);
+            stack_.back() = resobj;
             return;
         }
-        if (func_name == Scope::yapvm_thread_func_name) {
-            if (call->args().size() != 2) {
-                throw std::runtime_error("Interpreter: thread should have 2 params - function and args to call");
-            }
-            if (dynamic_cast<Name *>(call->args()[0].get()) == nullptr) {
-                throw std::runtime_error("Interpreter: thread first argument should be function name");
-            }
-            std::string callee_name = dynamic_cast<Name *>(call->args()[0].get())->id();
-            ScopeEntry callee_sce = scope_->name_lookup(Scope::scope_entry_function_name(callee_name));
-            if (callee_sce.type_ != FUNCTION) {
-                throw std::runtime_error("Interpreterer: cannot find function " + callee_name);
-            }
-            FunctionDef *callee = static_cast<FunctionDef *>(callee_sce.value_);
-            if (callee->args().size() != 1) {
-                throw std::runtime_error("Interpreter: thread callee should have only one argument");
-            }
-
-            interpret_expr(call->args()[1]);
-            ManagedObject *arg = LAST_EXEC_RES_M_YOBJ;
-
-            size_t id;
-            do {
-                id = GLOBAL_BORN_THREAD_ID.load();
-            } while (!GLOBAL_BORN_THREAD_ID.compare_exchange_strong(id, id + 1));
-            std::string thread_name = Scope::scope_entry_thread_name(id);
-
-            scope_->change(thread_name, ScopeEntry{ new Scope{scope_}, SCOPE });
-            Scope *thread_scope = static_cast<Scope *>(scope_->get(thread_name).value().value_);
-            thread_scope->change(callee->args()[0], ScopeEntry{ arg, OBJECT });
-            Interpreter *thread = new Interpreter{
-                new Module{ copy_vec_no_owning(callee->body()) }, thread_manager_, thread_scope
-            };
-            thread->launch();
-
-            ManagedObject *resobj = new ManagedObject{
-                new YObject{ "int", new ssize_t{ static_cast<ssize_t>(reinterpret_cast<size_t>(thread)) } }
-            };
-            scope_->update_last_exec_res(resobj);
-            Logger::log("Interpreter",
-                "created and launched new thread with interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(thread))
-                + "] from interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(this))
-                + "]"
-            );
+        case NodeKind::Compare: {
+            Compare *compare = static_cast<Compare *>(code);
+            if (compare->comparators().size() != 1) {
+                throw std::runtime_error("Interpreter: Compare currently supported only with one argument");
+            }
+            interpret_expr(compare->left());
+            interpret_expr(compare->comparators()[0]);
+
+            Value resobj = eval_compare(bytecode::compare_operator(compare->ops()[0]), stack_[stack_.size() - 2], stack_.back());
+            stack_.pop_back();
+            stack_.back() = resobj;
             return;
         }
-        if (func_name == Scope::yapvm_thread_join_func_name) {
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: thread join can have only one argument");
+        case NodeKind::Call: {
+            Call *call = static_cast<Call *>(code);
+            if (call->func()->kind() != NodeKind::Name && call->func()->kind() != NodeKind::Attribute) {
+                throw std::runtime_error("Interpreter: Call.func should be Name");
             }
-            interpret_expr(call->args()[0].get());
 
-            YObject *thr_sce_name_object = LAST_EXEC_RES_YOBJ;
-            if (thr_sce_name_object->get_typename() != "int") {
-                throw std::runtime_error("Interpreter: unrecognized thread object");
+            if (call->func()->kind() == NodeKind::Attribute) {
+                Attribute *attribute = static_cast<Attribute *>(call->func().get());
+                interpret_expr(attribute->value());
+                if (stack_.back().get_type() != YType::List) {
+                    throw std::runtime_error("Interpreter: Currently only list attributes");
+                }
+
+                if (attribute->attr() != "append") {
+                    throw std::runtime_error("Interpreter: Currently supported only list.append as attribute");
+                }
+                if (call->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: list.append require 1 argument");
+                }
+                interpret_expr(call->args()[0]);
+
+                stack_[stack_.size() - 2].object()->add_list_element(stack_.back());
+                stack_[stack_.size() - 2] = stack_.back();
+                stack_.pop_back();
+                return;
             }
-            Interpreter *thread = reinterpret_cast<Interpreter *>(
-                static_cast<size_t>(thr_sce_name_object->get_value_as_int())
-            );
 
-            Logger::log("Interpreter",
-                "waiting to join thread with interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(thread))
-                + "] from interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(this))
-                + "]"
-            );
-            std::optional<bool> is_thread_registered_opt = thread_manager_->is_registered(thread);
-            while (true) {
-                if (is_thread_registered_opt.has_value()) {
-                    if (!is_thread_registered_opt.value()) {
-                        break;
-                    }
-                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+            std::string func_name = static_cast<Name *>(call->func().get())->id().str();
+            if (func_name == "print") {
+                if (call->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: print can take only 1 argument");
                 }
-                is_thread_registered_opt = thread_manager_->is_registered(thread);
-                handle_safepoint();
+                interpret_expr(call->args()[0]);
+                Value print_arg = stack_.back();
+                if (print_arg.get_type() != YType::String) {
+                    throw std::runtime_error("Interpreter: print argument should be string");
+                }
+                std::cout << print_arg.yobject()->get_value_as_string();
+                return;
             }
-            while (!thread_manager_->finish_waiting()) {
-                handle_safepoint();
+            if (func_name == Scope::yapvm_thread_func_name) {
+                if (call->args().size() != 2) {
+                    throw std::runtime_error("Interpreter: thread should have 2 params - function and args to call");
+                }
+                if (call->args()[0]->kind() != NodeKind::Name) {
+                    throw std::runtime_error("Interpreter: thread first argument should be function name");
+                }
+                std::string callee_name = static_cast<Name *>(call->args()[0].get())->id().str();
+                ScopeEntry callee_sce = scope_->name_lookup(Scope::scope_entry_function_name(callee_name));
+                if (callee_sce.type_ != FUNCTION) {
+                    throw std::runtime_error("Interpreterer: cannot find function " + callee_name);
+                }
+                FunctionDef *callee = static_cast<FunctionDef *>(callee_sce.value_);
+                if (callee->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: thread callee should have only one argument");
+                }
+
+                interpret_expr(call->args()[1]);
+                stack_.back() = spawn_thread(callee, stack_.back());
+                return;
             }
-            handle_safepoint();
-            Logger::log("Interpreter",
-                "joined thread with interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(thread))
-                + "] from interpreter ["
-                + std::to_string(reinterpret_cast<size_t>(this))
-                + "]"
-            );
-            return;
-        }
-        //TODO dict
-        if (func_name == "str") {
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: str can take only 1 argument");
-            }
-            interpret_expr(call->args()[0]);
-            YObject *arg = LAST_EXEC_RES_YOBJ;
-
-            ManagedObject *resobj = nullptr;
-            if (arg->get_typename() == "string") {
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{ arg->get_value_as_string() } } };
-            } else if (arg->get_typename() == "int") {
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{ std::to_string(arg->get_value_as_int()) } } };
-            } else if (arg->get_typename() == "float") {
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{ std::to_string(arg->get_value_as_float()) } } };
-            } else if (arg->get_typename() == "bool") {
-                std::string val = "False";
-                if (arg->get_value_as_bool()) {
-                    val = "True";
-                }
-                resobj = new ManagedObject{ new YObject{ "string", new std::string{  std::move(val) } } };
-            }
-
-            if (resobj == nullptr) {
-                throw std::runtime_error("Interpreter: cannot construct string from " + arg->get_typename());
-            }
-            register_queue_.push(resobj);
-            scope_->update_last_exec_res(resobj);
-            return;
-        }
-        if (func_name == "int") {
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: int can take only 1 argument");
+            if (func_name == Scope::yapvm_thread_join_func_name) {
+                if (call->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: thread join can have only one argument");
+                }
+                interpret_expr(call->args()[0].get());
+
+                join_thread(stack_.back());
+                return;
             }
-            interpret_expr(call->args()[0]);
-            YObject *arg = LAST_EXEC_RES_YOBJ;
+            //TODO dict
+            if (func_name == "str" || func_name == "int" || func_name == "float") {
+                if (call->args().size() != 1) {
+                    throw std::runtime_error("Interpreter: " + func_name + " can take only 1 argument");
+                }
+                interpret_expr(call->args()[0]);
 
-            ManagedObject *resobj = nullptr;
-            if (arg->get_typename() == "string") {
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ from_str<ssize_t>(arg->get_value_as_string()) } } };
-            } else if (arg->get_typename() == "int") {
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ arg->get_value_as_int() } } };
-            } else if (arg->get_typename() == "float") {
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ static_cast<ssize_t>(arg->get_value_as_float()) } } };
-            } else if (arg->get_typename() == "bool") {
-                ssize_t val = 0;
-                if (arg->get_value_as_bool()) {
-                    val = 1;
+                bytecode::Conversion conv = bytecode::CONV_STR;
+                if (func_name == "int") {
+                    conv = bytecode::CONV_INT;
+                } else if (func_name == "float") {
+                    conv = bytecode::CONV_FLOAT;
+                }
+                Value resobj = eval_convert(conv, stack_.back());
+                register_value(resobj);
+                stack_.back() = resobj;
+                return;
+            }
+            if (func_name == "list") {
+                if (!call->args().empty()) {
+                    throw std::runtime_error("Interpreter: list constructor cannot take arguments");
                 }
-                resobj = new ManagedObject{ new YObject{ "int", new ssize_t{ val } } };
+                ManagedObject *resobj = new ManagedObject{ constr_ylist() };
+                register_value(resobj);
+                stack_.push_back(resobj);
+                return;
             }
 
-            if (resobj == nullptr) {
-                throw std::runtime_error("Interpreter: cannot construct int from " + arg->get_typename());
+            FunctionDef *function_def = static_cast<FunctionDef *>(
+                scope_->name_lookup(Scope::scope_entry_function_name(func_name)).value_
+            );
+            size_t args_base = stack_.size(); // evaluated args are held on operand stack
+            for (Expr *e : call->args()) {
+                interpret_expr(e);
             }
-            register_queue_.push(resobj);
-            scope_->update_last_exec_res(resobj);
-            return;
-        }
-        if (func_name == "float") {
-            if (call->args().size() != 1) {
-                throw std::runtime_error("Interpreter: float can take only 1 argument");
+            std::vector<Value> call_args{ stack_.begin() + static_cast<ssize_t>(args_base), stack_.end() };
+            stack_.resize(args_base);
+            std::string scope_name = Scope::scope_entry_call_subscope_name(func_name);
+            scope_->change(scope_name, ScopeEntry{ new Scope{ scope_ }, SCOPE });
+            scope_ = static_cast<Scope *>(scope_->get(scope_name).value().value_);
+
+            if (call->args().size() != function_def->args().size()) {
+                throw std::runtime_error("Interpreter: invalid number of arguments for function " + func_name);
             }
-            interpret_expr(call->args()[0]);
-            YObject *arg = LAST_EXEC_RES_YOBJ;
-
-            ManagedObject *resobj = nullptr;
-            if (arg->get_typename() == "string") {
-                resobj = new ManagedObject{ new YObject{ "float", new double{ from_str<double>(arg->get_value_as_string()) } } };
-            } else if (arg->get_typename() == "int") {
-                resobj = new ManagedObject{ new YObject{ "float", new double{ static_cast<double>(arg->get_value_as_int()) } } };
-            } else if (arg->get_typename() == "float") {
-                resobj = new ManagedObject{ new YObject{ "float", new double{ arg->get_value_as_float() } } };
+            for (size_t i = 0; i < call->args().size(); i++) {
+                scope_->change(function_def->args()[i], ScopeEntry{ nullptr, OBJECT, call_args[i] });
             }
-
-            if (resobj == nullptr) {
-                throw std::runtime_error("Interpreter: cannot construct float from " + arg->get_typename());
+            handle_safepoint(); // function entry, arguments are rooted in callee scope already
+            for (Stmt *stmt : function_def->body()) {
+                if (!interpret(stmt)) {
+                    break;
+                }
+            }
+            if (function_def->body()[function_def->body().size() - 1]->kind() != NodeKind::Return) {
+                throw std::runtime_error("Interpreter: function should end with return statement");
             }
-            register_queue_.push(resobj);
-            scope_->update_last_exec_res(resobj);
+            // return left its result on operand stack and switched back to caller scope
+            assert(stack_.size() == args_base + 1);
+            scope_->del(scope_name); // TODO check
             return;
         }
-        if (func_name == "list") {
-            if (!call->args().empty()) {
-                throw std::runtime_error("Interpreter: list constructor cannot take arguments");
+        case NodeKind::Constant: {
+            Constant *constant = static_cast<Constant *>(code);
+            YObject *c_val = constant->value(); //TODO bug probably here with double c_val deletion
+            Value resobj{};
+            if (c_val->get_type() == YType::Bool) {
+                resobj = Value::from_bool(c_val->get_value_as_bool());
+            } else if (c_val->get_type() == YType::Int) {
+                resobj = Value::from_int(c_val->get_value_as_int());
+            } else if (c_val->get_type() == YType::Float) {
+                resobj = Value::from_float(c_val->get_value_as_float());
+            } else if (c_val->get_type() == YType::String) {
+                resobj = new ManagedObject{ constr_ystring(c_val->get_value_as_string()) };
             }
-            ManagedObject *resobj = new ManagedObject{ new YObject{ "list", new std::vector<ManagedObject *>{} } };
-            register_queue_.push(resobj);
-            scope_->update_last_exec_res(resobj);
+            assert(!resobj.is_object() || resobj.object() != nullptr);
+            register_value(resobj);
+            stack_.push_back(resobj);
             return;
         }
-
-        FunctionDef *function_def = static_cast<FunctionDef *>(
-            scope_->name_lookup(Scope::scope_entry_function_name(func_name)).value_
-        );
-        std::vector<ManagedObject *> call_args;
-        for (Expr *e : call->args()) {
-            interpret_expr(e);
-            call_args.push_back(LAST_EXEC_RES_M_YOBJ);
-        }
-        std::string scope_name = Scope::scope_entry_call_subscope_name(func_name);
-        scope_->change(scope_name, ScopeEntry{ new Scope{ scope_ }, SCOPE });
-        scope_ = static_cast<Scope *>(scope_->get(scope_name).value().value_);
-
-        if (call->args().size() != function_def->args().size()) {
-            throw std::runtime_error("Interpreter: invalid number of arguments for function " + func_name);
-        }
-        for (size_t i = 0; i < call->args().size(); i++) {
-            scope_->change(function_def->args()[i], ScopeEntry{ call_args[i], OBJECT });
-        }
-        for (Stmt *stmt : function_def->body()) {
-            if (!interpret(stmt)) {
-                break;
+        case NodeKind::Name: {
+            Name *name = static_cast<Name *>(code);
+            ScopeEntry n_sce = scope_->name_lookup(name->id());
+            if (n_sce.type_ != OBJECT) {
+                throw std::runtime_error("Interpreter: " + name->id().str() + " is not name of object");
             }
+            stack_.push_back(n_sce.object_);
+            return;
         }
-        if (dynamic_cast<Return *>(function_def->body()[function_def->body().size() - 1].get()) == nullptr) {
-            throw std::runtime_error("Interpreter: function should end with return statement");
-        }
-        // expected that function ended with return -> should some kind of a delete allocated scope
-        scope_->del(scope_name); // TODO check
-        return;
-    }
-    if (instanceof<Constant>(code)) {
-        Constant *constant = dynamic_cast<Constant *>(code);
-        YObject *c_val = constant->value(); //TODO bug probably here with double c_val deletion
-        YObject *c_val_cpy = nullptr;
-        if (c_val->get_typename() == "bool") {
-            c_val_cpy = new YObject{ "bool", new bool{ c_val->get_value_as_bool() } };
-        } else if (c_val->get_typename() == "int") {
-            c_val_cpy = new YObject{ "int", new ssize_t{ c_val->get_value_as_int() } };
-        } else if (c_val->get_typename() == "float") {
-            c_val_cpy = new YObject{ "float", new double{ c_val->get_value_as_float() } };
-        } else if (c_val->get_typename() == "string") {
-            c_val_cpy = new YObject{ "string", new std::string{ c_val->get_value_as_string() } };
-        }
-        assert(c_val_cpy != nullptr);
-        ManagedObject *resobj = new ManagedObject{ c_val_cpy };
-        register_queue_.push(resobj);
-        scope_->update_last_exec_res(resobj);
-        return;
-    }
-    if (instanceof<Name>(code)) {
-        Name *name = dynamic_cast<Name *>(code);
-        ScopeEntry n_sce = scope_->name_lookup(name->id());
-        if (n_sce.type_ != OBJECT) {
-            throw std::runtime_error("Interpreter: " + name->id() + " is not name of object");
-        }
-        scope_->update_last_exec_res(static_cast<ManagedObject *>(n_sce.value_));
-        return;
-    }
-    if (instanceof<Subscript>(code)) {
-        Subscript *subscript = dynamic_cast<Subscript *>(code);
-
-        interpret_expr(subscript->value());
-        YObject *value = LAST_EXEC_RES_YOBJ;
-        if (value->get_typename() != "list") {
-            throw std::runtime_error("Interpreter: Subscript currently supported only for lists");
-        }
+        case NodeKind::Subscript: {
+            Subscript *subscript = static_cast<Subscript *>(code);
 
-        interpret_expr(subscript->key());
-        YObject *key = LAST_EXEC_RES_YOBJ;
-        if (key->get_typename() != "int") {
-            throw std::runtime_error("Interpreter: Subscript key for list should be int");
-        }
+            interpret_expr(subscript->value());
+            interpret_expr(subscript->key());
 
-        ssize_t key_v = key->get_value_as_int();
-        if (std::abs(key_v) >= value->get_len_as_list()) {
-            throw std::runtime_error("Interpreter: list index out of range");
-        }
-        if (key_v < 0) {
-            key_v = static_cast<ssize_t>(key->get_len_as_list()) - key_v;
+            Value element = subscript_load(stack_[stack_.size() - 2], stack_.back());
+            stack_.pop_back();
+            stack_.back() = element;
+            return;
         }
-        ManagedObject *element = value->get_list_element(key_v);
-        scope_->update_last_exec_res(element); // TODO check
-        return;
+        default:
+            break;
     }
     //TODO attribute, subscript
 
@@ -781,144 +935,151 @@ bool yapvm::interpreter::Interpreter::interpret_stmt(Stmt *code) {
     assert(code != nullptr);
     handle_safepoint();
 
-    if (instanceof<Import>(code)) {
-        return true; // currently just ignore
-    }
-    if (instanceof<FunctionDef>(code)) {
-        FunctionDef *fdef = dynamic_cast<FunctionDef *>(code);
-        scope_->change(Scope::scope_entry_function_name(fdef->name()), ScopeEntry{ fdef, FUNCTION });
-        return true;
-    }
-    if (instanceof<ClassDef>(code)) {
-        throw std::runtime_error("Interpreter: ClassDef currently not supported");
-    }
-    if (instanceof<Return>(code)) {
-        Return *rt = dynamic_cast<Return *>(code);
-
-        if (rt->returns_anything()) {
-            interpret_expr(rt->value());
+    switch (code->kind()) {
+        case NodeKind::Import: {
+            return true; // currently just ignore
         }
-
-        if (scope_ == main_scope_) {
-            finishing_.store(true);
-            delete main_scope_;
-            return false;
+        case NodeKind::FunctionDef: {
+            FunctionDef *fdef = static_cast<FunctionDef *>(code);
+            scope_->change(Scope::scope_entry_function_name(fdef->name()), ScopeEntry{ fdef, FUNCTION });
+            return true;
         }
-        Scope *prev = scope_;
-        scope_ = scope_->parent();
-        scope_->change(Scope::lst_exec_res, prev->get(Scope::lst_exec_res).value());
-        delete prev;
-        return false;
-    }
-    if (instanceof<Assign>(code)) {
-        //TODO add assign to subscript
-        Assign *assign = dynamic_cast<Assign *>(code);
-        if (assign->target().size() != 1 || (!instanceof<Name>(assign->target()[0].get()) && !instanceof<Subscript>(assign->target()[0].get()))) {
-            throw std::runtime_error("Interpreter: currently can assign only to single Name");
+        case NodeKind::ClassDef: {
+            throw std::runtime_error("Interpreter: ClassDef currently not supported");
         }
-        if (instanceof<Name>(assign->target()[0].get())) {
-            Name *target = dynamic_cast<Name *>(assign->target()[0].get());
-            assert(target != nullptr);
-            interpret_expr(assign->value());
-            scope_->store_last_exec_res(target->id());
-        } else if (instanceof<Subscript>(assign->target()[0].get())) {
-            Subscript *subscript = dynamic_cast<Subscript *>(assign->target()[0].get());
-            assert(subscript != nullptr);
+        case NodeKind::Return: {
+            Return *rt = static_cast<Return *>(code);
 
-            interpret_expr(subscript->value());
-            YObject *value = LAST_EXEC_RES_YOBJ;
-            if (value->get_typename() != "list") {
-                throw std::runtime_error("Interpreter: currently can assign only to list subscript");
-            }
-            interpret_expr(subscript->key());
-            YObject *key = LAST_EXEC_RES_YOBJ;
-            if (key->get_typename() != "int") {
-                throw std::runtime_error("Interpreter: list subscript key should be int");
+            if (rt->returns_anything()) {
+                interpret_expr(rt->value());
+            } else {
+                stack_.push_back(Value::none());
             }
-            size_t idx = static_cast<size_t>(key->get_value_as_int());
 
-            interpret_expr(assign->value());
-            ManagedObject *assignee = LAST_EXEC_RES_M_YOBJ;
-            value->set_list_element(idx, assignee);
-            scope_->update_last_exec_res(assignee);
+            if (scope_ == main_scope_) {
+                stack_.pop_back(); // thread result is not used
+                finishing_.store(true); // main scope is owned by parent scope or gc root, it is not deleted here
+                return false;
+            }
+            Scope *prev = scope_;
+            scope_ = scope_->parent();
+            delete prev;
+            return false;
         }
-        return true;
-    }
-    if (instanceof<AugAssign>(code)) {
-        AugAssign *aug_assign = dynamic_cast<AugAssign *>(code);
+        case NodeKind::Assign: {
+            //TODO add assign to subscript
+            Assign *assign = static_cast<Assign *>(code);
+            if (assign->target().size() != 1 || (assign->target()[0]->kind() != NodeKind::Name && assign->target()[0]->kind() != NodeKind::Subscript)) {
+                throw std::runtime_error("Interpreter: currently can assign only to single Name");
+            }
+            if (assign->target()[0]->kind() == NodeKind::Name) {
+                Name *target = static_cast<Name *>(assign->target()[0].get());
+                assert(target != nullptr);
+                interpret_expr(assign->value());
+                scope_->change(target->id(), ScopeEntry{ nullptr, OBJECT, stack_.back() });
+                stack_.pop_back();
+            } else if (assign->target()[0]->kind() == NodeKind::Subscript) {
+                Subscript *subscript = static_cast<Subscript *>(assign->target()[0].get());
+                assert(subscript != nullptr);
+
+                interpret_expr(subscript->value());
+                if (stack_.back().get_type() != YType::List) {
+                    throw std::runtime_error("Interpreter: currently can assign only to list subscript");
+                }
+                interpret_expr(subscript->key());
+                if (stack_.back().get_type() != YType::Int) {
+                    throw std::runtime_error("Interpreter: list subscript key should be int");
+                }
 
-        interpret_expr(aug_assign->target());
-        YObject *target = LAST_EXEC_RES_YOBJ;
-        if (target->get_typename() != "list") {
-            throw std::runtime_error("Interpreter: currently AugAssign supported only for lists");
-        }
-        if (dynamic_cast<Add *>(aug_assign->op().get()) == nullptr) {
-            throw std::runtime_error("Interpreter: currently AugAssign for lists supported only for Add");
+                interpret_expr(assign->value());
+                Value value = stack_[stack_.size() - 3];
+                size_t idx = list_index(value, stack_[stack_.size() - 2].get_value_as_int());
+                value.object()->set_list_element(idx, stack_.back());
+                stack_.resize(stack_.size() - 3);
+            }
+            return true;
         }
+        case NodeKind::AugAssign: {
+            AugAssign *aug_assign = static_cast<AugAssign *>(code);
 
-        interpret_expr(aug_assign->value());
-        ManagedObject *value = LAST_EXEC_RES_M_YOBJ;
-        target->add_list_element(value);
-        scope_->update_last_exec_res(value);
-        return true;
-    }
-    if (instanceof<While>(code)) {
-        While *while_ = dynamic_cast<While *>(code);
-        while (true) {
-            interpret_expr(while_->test());
-            YObject *test_res = LAST_EXEC_RES_YOBJ;
-            if (test_res->get_typename() != "bool") {
-                throw std::runtime_error("Interpreter: While.test expression should be bool");
-            }
-            if (!test_res->get_value_as_bool()) {
-                break;
+            interpret_expr(aug_assign->target());
+            if (stack_.back().get_type() != YType::List) {
+                throw std::runtime_error("Interpreter: currently AugAssign supported only for lists");
+            }
+            if (aug_assign->op()->kind() != NodeKind::Add) {
+                throw std::runtime_error("Interpreter: currently AugAssign for lists supported only for Add");
             }
-            for (Stmt *stmt : while_->body()) {
-                if (!interpret_stmt(stmt)) {
+
+            interpret_expr(aug_assign->value());
+            stack_[stack_.size() - 2].object()->add_list_element(stack_.back());
+            stack_.resize(stack_.size() - 2);
+            return true;
+        }
+        case NodeKind::While: {
+            While *while_ = static_cast<While *>(code);
+            while (true) {
+                interpret_expr(while_->test());
+                Value test_res = stack_.back();
+                stack_.pop_back();
+                if (test_res.get_type() != YType::Bool) {
+                    throw std::runtime_error("Interpreter: While.test expression should be bool");
+                }
+                if (!test_res.get_value_as_bool()) {
                     break;
                 }
+                handle_safepoint(); // back-edge, same as SAFEPOINT at loop start in bytecode
+                for (Stmt *stmt : while_->body()) {
+                    if (!interpret_stmt(stmt)) {
+                        break;
+                    }
+                }
             }
+            return true;
         }
-        return true;
-    }
-    if (instanceof<For>(code)) {
-        throw std::runtime_error("Interpreter: currently only while loops are supported");
-    }
-    if (instanceof<With>(code)) {
-        throw std::runtime_error("Interpreter: currently With are not supported");
-    }
-    if (instanceof<If>(code)) {
-        If *if_ = dynamic_cast<If *>(code);
-
-        interpret_expr(if_->test());
-        YObject *test_res = LAST_EXEC_RES_YOBJ;
-        if (test_res->get_typename() != "bool") {
-            throw std::runtime_error("Interpreter: If.test expression should be bool");
+        case NodeKind::For: {
+            throw std::runtime_error("Interpreter: currently only while loops are supported");
         }
-        if (test_res->get_value_as_bool()) {
-            for (Stmt *stmt : if_->body()) {
-                if (!interpret_stmt(stmt)) {
-                    return false;
-                }
+        case NodeKind::With: {
+            throw std::runtime_error("Interpreter: currently With are not supported");
+        }
+        case NodeKind::If: {
+            If *if_ = static_cast<If *>(code);
+
+            interpret_expr(if_->test());
+            Value test_res = stack_.back();
+            stack_.pop_back();
+            if (test_res.get_type() != YType::Bool) {
+                throw std::runtime_error("Interpreter: If.test expression should be bool");
             }
-        } else {
-            for (Stmt *stmt : if_->orelse()) {
-                if (!interpret_stmt(stmt)) {
-                    return false;
+            if (test_res.get_value_as_bool()) {
+                for (Stmt *stmt : if_->body()) {
+                    if (!interpret_stmt(stmt)) {
+                        return false;
+                    }
+                }
+            } else {
+                for (Stmt *stmt : if_->orelse()) {
+                    if (!interpret_stmt(stmt)) {
+                        return false;
+                    }
                 }
             }
+            return true;
         }
-        return true;
-    }
-    if (instanceof<ExprStmt>(code)) {
-        interpret_expr(dynamic_cast<ExprStmt *>(code)->value());
-        return true;
-    }
-    if (instanceof<Pass>(code)) {
-        return true; // just skip pass instr
-    }
-    if (instanceof<Continue>(code) || instanceof<Break>(code)) {
-        throw std::runtime_error("Interpreter: in current version Break and Continue statements are not supported");
+        case NodeKind::ExprStmt: {
+            interpret_expr(static_cast<ExprStmt *>(code)->value());
+            stack_.pop_back();
+            return true;
+        }
+        case NodeKind::Pass: {
+            return true; // just skip pass instr
+        }
+        case NodeKind::Continue:
+        case NodeKind::Break: {
+            throw std::runtime_error("Interpreter: in current version Break and Continue statements are not supported");
+        }
+        default:
+            break;
     }
 
     throw std::runtime_error("Interpreter: unexpected statement");
@@ -927,27 +1088,34 @@ bool yapvm::interpreter::Interpreter::interpret_stmt(Stmt *code) {
 
 bool yapvm::interpreter::Interpreter::interpret(Node *code) {
     assert(code != nullptr);
-    if (instanceof<Stmt>(code)) {
-        return interpret_stmt(dynamic_cast<Stmt *>(code));
+    if (is_stmt_kind(code->kind())) {
+        return interpret_stmt(static_cast<Stmt *>(code));
     }
     throw std::runtime_error("Interpreter: interpret() can deal only with Stmt-s");
 }
 
 
-yapvm::interpreter::Interpreter::Interpreter(scoped_ptr<Module> &&code, ThreadManager *tm, Scope *scope) :
+yapvm::interpreter::Interpreter::Interpreter(scoped_ptr<Module> &&code, ThreadManager *tm, Scope *scope, ExecMode mode) :
     code_{code.steal()}, scope_{scope}, main_scope_{scope_}, thread_manager_{tm} {
-    while (!tm->register_interpreter(this)) {
-        handle_safepoint();
+    if (mode == BYTECODE) {
+        program_ = compiler::compile(code_);
+        entry_ = program_->module();
+        scope_->bind_slots(&entry_->locals_); // globals
     }
 }
 
 
+// thread interpreter in bytecode mode, program is owned by interpreter which compiled it
+yapvm::interpreter::Interpreter::Interpreter(bytecode::Program *program, const bytecode::CodeObject *entry, ThreadManager *tm, Scope *scope) :
+    code_{nullptr}, scope_{scope}, main_scope_{scope_}, thread_manager_{tm}, program_{program, false}, entry_{entry} {}
+
+
 yapvm::interpreter::Interpreter::~Interpreter() {
     delete code_;
 }
 
 
-void yapvm::interpreter::Interpreter::park() { need_park_.store(true); }
+void yapvm::interpreter::Interpreter::park() { need_park_.store(true, std::memory_order_release); }
 
 
 bool yapvm::interpreter::Interpreter::is_parked() const {
@@ -955,11 +1123,14 @@ bool yapvm::interpreter::Interpreter::is_parked() const {
 }
 
 
-void yapvm::interpreter::Interpreter::run() {
-    need_unpark_.store(true);
-}
-
-void yapvm::interpreter::Interpreter::launch() {
+void yapvm::interpreter::Interpreter::launch(Interpreter *parent) {
+    // gc keeps thread manager locked while it parks interpreters, so parent should reach its safepoint meanwhile
+    while (!thread_manager_->register_interpreter(this)) {
+        if (parent != nullptr) {
+            parent->handle_safepoint();
+        }
+    }
+    main_scope_->set_thread_root(true);
     worker_ = std::thread{&Interpreter::__worker_exec, this, code_};
 }
 
@@ -973,11 +1144,49 @@ yapvm::interpreter::Scope *yapvm::interpreter::Interpreter::get_scope() const {
 }
 
 
-std::vector<yapvm::yobjects::ManagedObject *> yapvm::interpreter::Interpreter::get_register_queue() {
-    std::vector<ManagedObject *> ret;
-    while (!register_queue_.empty()) {
-        ret.push_back(register_queue_.top());
-        register_queue_.pop();
+std::vector<yapvm::yobjects::Value> &yapvm::interpreter::Interpreter::get_stack() {
+    return stack_;
+}
+
+
+const std::vector<yapvm::yobjects::Value> &yapvm::interpreter::Interpreter::get_stack() const {
+    return stack_;
+}
+
+
+void yapvm::interpreter::Interpreter::visit_roots(const std::function<void(Value &)> &visit) {
+    main_scope_->visit_values(visit); // scopes of ast interpreter calls are children of main scope
+    for (Frame *frame = frame_; frame != nullptr; frame = frame->caller_) {
+        for (uint32_t i = 0; i < frame->slots_count_; i++) {
+            if (!Scope::is_unbound(frame->slots()[i])) {
+                visit(frame->slots()[i]);
+            }
+        }
+        if (frame->dynamic_ != nullptr) {
+            frame->dynamic_->visit_values(visit);
+        }
     }
-    return ret;
+    for (Value &v : stack_) {
+        visit(v);
+    }
+}
+
+
+void yapvm::interpreter::Interpreter::register_value(Value value) {
+    if (value.is_object()) {
+        value.object()->set_generation(Generation::Young);
+        register_queue_.push(value.object());
+        registered_.store(register_queue_.size(), std::memory_order_relaxed);
+    }
+}
+
+
+yapvm::ygc::ObjectList yapvm::interpreter::Interpreter::take_register_queue() {
+    registered_.store(0, std::memory_order_relaxed);
+    return std::move(register_queue_);
+}
+
+
+size_t yapvm::interpreter::Interpreter::registered() const {
+    return registered_.load(std::memory_order_relaxed);
 }
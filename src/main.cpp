@@ -1,4 +1,6 @@
+#include <cstdlib>
 #include <iostream>
+#include <optional>
 
 #include "gc.h"
 #include "interpreter.h"
@@ -12,42 +14,110 @@ using namespace yapvm::parser;
 using namespace yapvm::interpreter;
 
 
+// bytes with optional k[b], m[b], g[b] suffix, e.g. 512mb
+static std::optional<size_t> parse_heap_size(const std::string &str) {
+    size_t digits = 0;
+    while (digits < str.size() && std::isdigit(static_cast<unsigned char>(str[digits]))) {
+        digits++;
+    }
+    if (digits == 0) {
+        return std::nullopt;
+    }
+    size_t res = std::stoull(str.substr(0, digits));
+    std::string unit = str.substr(digits);
+    for (char &c : unit) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (unit == "k" || unit == "kb") {
+        res *= 1024;
+    } else if (unit == "m" || unit == "mb") {
+        res *= 1024 * 1024;
+    } else if (unit == "g" || unit == "gb") {
+        res *= 1024 * 1024 * 1024;
+    } else if (!unit.empty()) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+
 int main(int argc, char **argv) {
     if (argc < 2) {
         std::cout << "Error: need to specify main file" << std::endl;
-    } else if (argc > 4) {
-        std::cout << "Error: too much args" << std::endl;
+        return 1;
     }
 
+    size_t max_heap = SIZE_MAX;
+    size_t min_heap = 0;
+    ExecMode mode = BYTECODE;
+    size_t gc_threads = 0; // markers, 0 - by hardware concurrency
+    bool compaction = true;
+    std::string gc_stats_path; // json line per gc cycle
+    std::string heap_dump_path; // live objects after major collection
+    for (int i = 2; i < argc; i++) {
+        std::string arg(argv[i]);
+        if ((arg == "-Xmx" || arg == "-Xms") && i + 1 < argc) {
+            std::optional<size_t> size = parse_heap_size(argv[++i]);
+            if (!size.has_value() || size.value() == 0) {
+                std::cout << "Error: invalid heap size " << argv[i] << std::endl;
+                return 1;
+            }
+            (arg == "-Xmx" ? max_heap : min_heap) = size.value();
+        } else if (arg == "-Xgcthreads" && i + 1 < argc) {
+            gc_threads = std::stoul(argv[++i]);
+        } else if (arg == "-Xgcstats" && i + 1 < argc) {
+            gc_stats_path = argv[++i];
+        } else if (arg == "-Xheapdump" && i + 1 < argc) {
+            heap_dump_path = argv[++i];
+        } else if (arg == "-Xnocompact") {
+            compaction = false; // old space is only swept, even if fragmented
+        } else if (arg == "-Xast") {
+            mode = TREE_WALKER; // old ast interpreter
+        } else {
+            std::cout << "Error: unknown arg " << arg << std::endl;
+            return 1;
+        }
+    }
 
-    Logger::init_logger();
 
-    scoped_ptr<Module> module = generate_ast(trim(read_file_ast(argv[1])));
+    if (min_heap > max_heap) {
+        std::cout << "Error: -Xms should not be greater than -Xmx" << std::endl;
+        return 1;
+    }
 
-    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    Logger::init_logger();
+    memory::Heap::instance().set_max_size(max_heap);
+    memory::Heap::instance().reserve(min_heap);
 
-    ThreadManager tm;
-    Interpreter *interpreter = new Interpreter(std::move(module), &tm);
+    std::chrono::steady_clock::time_point begin;
 
-    ygc::YGC* gc;
-    if (argc == 4 && std::string(argv[2]) == "-Xmx") {
-        std::string str_hs(argv[3]);
-        ssize_t hs = std::stoi(str_hs);
+    ThreadManager tm;
+    ygc::YGC *gc = nullptr;
+    try {
+        // string constants of module are slab allocated, so max heap size can be exceeded already here
+        scoped_ptr<Module> module = generate_ast(trim(read_file_ast(argv[1])));
+        begin = std::chrono::steady_clock::now();
 
-        if (str_hs.ends_with("mb")) {
-            hs *= 1024;
-        } else if (str_hs.ends_with("gb")) {
-            hs *= 1024 * 1024;
-        }
+        Interpreter *interpreter = new Interpreter(std::move(module), &tm, new Scope{}, mode);
 
-        gc = new ygc::YGC(interpreter->get_scope(), &tm, hs);
-    } else {
         gc = new ygc::YGC(interpreter->get_scope(), &tm);
-    }
+        gc->set_mark_threads(gc_threads);
+        gc->set_compaction(compaction);
+        if (!gc_stats_path.empty()) {
+            gc->stats().open(gc_stats_path);
+        }
+        gc->set_heap_dump(heap_dump_path);
 
-    interpreter->launch();
+        interpreter->launch();
 
-    gc->collect();
+        gc->collect();
+    } catch (const memory::OutOfMemory &e) {
+        // gc could not promote survivors or module did not fit, interpreters are parked and vm is stopped as a whole
+        Logger::log("GC", e.what());
+        std::cout.flush();
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::quick_exit(1);
+    }
 
     //Logger::log("no-gc wait other threads");
     //while (!tm.get_all_interpreters().value().empty()) {
@@ -56,6 +126,9 @@ int main(int argc, char **argv) {
     //tm.finish_waiting();
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
+    if (mode == BYTECODE) {
+        Logger::log("Interpreter", "inline cache: " + bytecode::call_cache_stats().summary());
+    }
     Logger::log(
         "main process finished in "+
         std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()) +
@@ -0,0 +1,91 @@
+#include "mark_deque.h"
+
+
+using namespace yapvm::ygc;
+using yapvm::yobjects::ManagedObject;
+
+
+yapvm::ygc::MarkDeque::Buffer::Buffer(int64_t capacity)
+    : capacity_{ capacity }, items_{ std::make_unique<std::atomic<ManagedObject *>[]>(static_cast<size_t>(capacity)) } {}
+
+
+ManagedObject *yapvm::ygc::MarkDeque::Buffer::get(int64_t idx) const {
+    return items_[static_cast<size_t>(idx & (capacity_ - 1))].load(std::memory_order_relaxed);
+}
+
+
+void yapvm::ygc::MarkDeque::Buffer::put(int64_t idx, ManagedObject *obj) {
+    items_[static_cast<size_t>(idx & (capacity_ - 1))].store(obj, std::memory_order_relaxed);
+}
+
+
+yapvm::ygc::MarkDeque::MarkDeque(int64_t capacity) {
+    buffers_.push_back(std::make_unique<Buffer>(capacity));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+
+MarkDeque::Buffer *yapvm::ygc::MarkDeque::grow(Buffer *old, int64_t bottom, int64_t top) {
+    buffers_.push_back(std::make_unique<Buffer>(old->capacity_ * 2));
+    Buffer *buffer = buffers_.back().get();
+    for (int64_t i = top; i < bottom; i++) {
+        buffer->put(i, old->get(i));
+    }
+    buffer_.store(buffer, std::memory_order_release);
+    return buffer;
+}
+
+
+void yapvm::ygc::MarkDeque::push(ManagedObject *obj) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+    if (b - t > buffer->capacity_ - 1) {
+        buffer = grow(buffer, b, t);
+    }
+    buffer->put(b, obj);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+}
+
+
+ManagedObject *yapvm::ygc::MarkDeque::pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    ManagedObject *obj = buffer->get(b);
+    if (t == b) {
+        // last element, race with thieves
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            obj = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return obj;
+}
+
+
+ManagedObject *yapvm::ygc::MarkDeque::steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+    ManagedObject *obj = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return obj;
+}
+
+
+bool yapvm::ygc::MarkDeque::empty() const {
+    return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+}
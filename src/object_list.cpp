@@ -0,0 +1,69 @@
+#include "object_list.h"
+
+#include <utility>
+
+#include "allocator.h"
+
+
+using namespace yapvm::ygc;
+
+
+static_assert(ObjectList::SEGMENT_BYTES <= yapvm::memory::SLAB_MAX_BLOCK);
+
+
+yapvm::ygc::ObjectList::~ObjectList() {
+    clear();
+}
+
+
+yapvm::ygc::ObjectList::ObjectList(ObjectList &&other) noexcept
+    : head_{ std::exchange(other.head_, nullptr) }, tail_{ std::exchange(other.tail_, nullptr) },
+      size_{ std::exchange(other.size_, 0) } {}
+
+
+ObjectList &yapvm::ygc::ObjectList::operator=(ObjectList &&other) noexcept {
+    if (this != &other) {
+        clear();
+        head_ = std::exchange(other.head_, nullptr);
+        tail_ = std::exchange(other.tail_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+
+void yapvm::ygc::ObjectList::grow() {
+    Segment *segment = static_cast<Segment *>(memory::slab_allocate(SEGMENT_BYTES));
+    segment->next_ = head_;
+    segment->size_ = 0;
+    head_ = segment;
+    if (tail_ == nullptr) {
+        tail_ = segment;
+    }
+}
+
+
+void yapvm::ygc::ObjectList::splice(ObjectList &&other) {
+    if (other.head_ == nullptr) {
+        return;
+    }
+    // segments of other go first, push continues to fill its head segment
+    other.tail_->next_ = head_;
+    if (tail_ == nullptr) {
+        tail_ = other.tail_;
+    }
+    head_ = std::exchange(other.head_, nullptr);
+    other.tail_ = nullptr;
+    size_ += std::exchange(other.size_, 0);
+}
+
+
+void yapvm::ygc::ObjectList::clear() {
+    while (head_ != nullptr) {
+        Segment *next = head_->next_;
+        memory::slab_deallocate(head_, SEGMENT_BYTES);
+        head_ = next;
+    }
+    tail_ = nullptr;
+    size_ = 0;
+}
@@ -217,6 +217,19 @@ static
 scoped_ptr<OperatorKind> generate_operator_kind(const std::string &input, size_t &pos);
 
 
+// operator category is checked by node kind, without dynamic_cast
+template <typename W>
+static
+scoped_ptr<W> operator_kind_or_error(scoped_ptr<OperatorKind> &&op, bool (*is_kind)(NodeKind), size_t pos, const std::string &line) {
+    OperatorKind *op_val = op.steal();
+    if (!is_kind(op_val->kind())) {
+        delete op_val;
+        parse_error(pos, __FILE__, line);
+    }
+    return static_cast<W *>(op_val);
+}
+
+
 static 
 scoped_ptr<Stmt>
 generate_aug_assign(const std::string &input, size_t &pos) {
@@ -228,7 +241,7 @@ generate_aug_assign(const std::string &input, size_t &pos) {
     assume(sstrcmp(input, ", op=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", op=") - 1;
 
-    scoped_ptr<BinOpKind> op = conv_or<OperatorKind, BinOpKind>(generate_operator_kind(input, pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
+    scoped_ptr<BinOpKind> op = operator_kind_or_error<BinOpKind>(generate_operator_kind(input, pos), is_bin_op_kind, pos, std::to_string(__LINE__));
 
     assume(sstrcmp(input, ", value=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", value=") - 1;
@@ -611,7 +624,7 @@ scoped_ptr<Expr> generate_bool_op(const std::string &input, size_t &pos) {
     assert(sstrcmp(input, "BoolOp(op=", pos));
 
     pos += sizeof("BoolOp(op=") - 1;
-    scoped_ptr<BoolOpKind> op = conv_or<OperatorKind, BoolOpKind>(generate_operator_kind(input, pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
+    scoped_ptr<BoolOpKind> op = operator_kind_or_error<BoolOpKind>(generate_operator_kind(input, pos), is_bool_op_kind, pos, std::to_string(__LINE__));
 
     assume(sstrcmp(input, ", values=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", values=") - 1;
@@ -633,7 +646,7 @@ scoped_ptr<Expr> generate_bin_op(const std::string &input, size_t &pos) {
 
     assume(sstrcmp(input, ", op=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", op=") - 1;
-    scoped_ptr<BinOpKind> op = conv_or<OperatorKind, BinOpKind>(generate_operator_kind(input, pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
+    scoped_ptr<BinOpKind> op = operator_kind_or_error<BinOpKind>(generate_operator_kind(input, pos), is_bin_op_kind, pos, std::to_string(__LINE__));
 
     assume(sstrcmp(input, ", right=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", right=") - 1;
@@ -650,7 +663,7 @@ scoped_ptr<Expr> generate_unary_op(const std::string &input, size_t &pos) {
     assert(sstrcmp(input, "UnaryOp(op=", pos));
 
     pos += sizeof("UnaryOp(op=") - 1;
-    scoped_ptr<UnaryOpKind> op = conv_or<OperatorKind, UnaryOpKind>(generate_operator_kind(input, pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
+    scoped_ptr<UnaryOpKind> op = operator_kind_or_error<UnaryOpKind>(generate_operator_kind(input, pos), is_unary_op_kind, pos, std::to_string(__LINE__));
     
     assume(sstrcmp(input, ", operand=", pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
     pos += sizeof(", operand=") - 1;
@@ -675,7 +688,7 @@ std::vector<scoped_ptr<CmpOpKind>> generate_cmp_op_vec(const std::string &input,
 
     std::vector<scoped_ptr<CmpOpKind>> ops;
     while (true) {
-        scoped_ptr<CmpOpKind> op = conv_or<OperatorKind, CmpOpKind>(generate_operator_kind(input, pos), parse_error, pos, __FILE__, std::to_string(__LINE__));
+        scoped_ptr<CmpOpKind> op = operator_kind_or_error<CmpOpKind>(generate_operator_kind(input, pos), is_cmp_op_kind, pos, std::to_string(__LINE__));
         ops.emplace_back(std::move(op));
         if (input[pos] == ',' && input[pos + 1] == ' ') {
             pos += 2;
@@ -959,4 +972,4 @@ scoped_ptr<Module> yapvm::parser::generate_ast(const std::string &input) {
     scoped_ptr<Module> module = generate_module(input, pos);
     assume(pos == input.size(), [] { throw std::runtime_error("AST generation error"); });
     return module;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -4,34 +4,73 @@ using namespace yapvm::interpreter;
 
 
 bool yapvm::interpreter::operator==(const ScopeEntry &a, const ScopeEntry &b) {
-    return a.type_ == b.type_ && a.value_ == b.value_;
+    return a.type_ == b.type_ && a.value_ == b.value_ && a.object_ == b.object_;
 }
 
-Scope::Scope() : parent_{ nullptr } {
-    scope_.add(lst_exec_res, ScopeEntry{ nullptr, OBJECT });
+uint32_t SlotLayout::add(Symbol name) {
+    auto [it, inserted] = index_.try_emplace(name, static_cast<uint32_t>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+    }
+    return it->second;
 }
 
 
-bool Scope::add_object(std::string name, ManagedObject *value) {
-    assert(value != nullptr);
-    return scope_.add(std::move(name), ScopeEntry{static_cast<void *>(value), OBJECT});
+std::optional<uint32_t> SlotLayout::find(Symbol name) const {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+
+std::atomic_uint64_t Scope::next_id_{ 1 };
+std::atomic_uint64_t Scope::functions_epoch_{ 0 };
+
+
+void Scope::function_changed() {
+    if (!frame_local_) {
+        functions_epoch_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+
+Scope::Scope() : parent_{ nullptr } {}
+
+
+bool Scope::add_object(Symbol name, Value value) {
+    assert(!value.is_object() || value.object() != nullptr);
+    return scope_.add(name, ScopeEntry{ nullptr, OBJECT, value });
 }
 
-bool Scope::add_function(std::string signature, FunctionDef *function) {
+bool Scope::add_function(Symbol signature, FunctionDef *function) {
     assert(function != nullptr);
-    return scope_.add(std::move(signature), ScopeEntry{static_cast<void *>(function), FUNCTION});
+    bool added = scope_.add(signature, ScopeEntry{static_cast<void *>(function), FUNCTION});
+    function_changed();
+    return added;
 }
 
-bool Scope::add_child_scope(std::string name, Scope *subscope) {
+bool Scope::add_child_scope(Symbol name, Scope *subscope) {
     assert(subscope != nullptr);
     subscope->parent_ = this;
-    return scope_.add(std::move(name), ScopeEntry{static_cast<void *>(subscope), SCOPE});
+    return scope_.add(name, ScopeEntry{static_cast<void *>(subscope), SCOPE});
 }
 
-bool Scope::add(std::string name, ScopeEntry entry) { return scope_.add(std::move(name), entry); }
+bool Scope::add(Symbol name, ScopeEntry entry) {
+    bool added = scope_.add(name, entry);
+    if (entry.type_ == FUNCTION) {
+        function_changed();
+    }
+    return added;
+}
 
 
-void Scope::change(const std::string &name, ScopeEntry new_entry) {
+void Scope::change(Symbol name, ScopeEntry new_entry) {
+    if (Value *slot = slot_of(name); slot != nullptr && new_entry.type_ == OBJECT) {
+        *slot = new_entry.object_;
+        return;
+    }
     std::optional<std::reference_wrapper<ScopeEntry>> opt_from_kv = scope_[name];
     if (!opt_from_kv.has_value()) {
         add(name, new_entry);
@@ -39,21 +78,27 @@ void Scope::change(const std::string &name, ScopeEntry new_entry) {
     }
 
     ScopeEntry &entry = opt_from_kv.value().get();
+    bool function = entry.type_ == FUNCTION || new_entry.type_ == FUNCTION;
     entry = new_entry;
+    if (function) {
+        function_changed();
+    }
 }
 
-void Scope::del(const std::string &name) {
+void Scope::del(Symbol name) {
+    if (Value *slot = slot_of(name); slot != nullptr) {
+        *slot = Value{};
+        return;
+    }
+    std::optional<std::reference_wrapper<ScopeEntry>> opt_from_kv = scope_[name];
+    bool function = opt_from_kv.has_value() && opt_from_kv.value().get().type_ == FUNCTION;
     scope_.del(name);
+    if (function) {
+        function_changed();
+    }
 }
 
-void Scope::store_last_exec_res(const std::string &name) { change(name, get(lst_exec_res).value()); }
-
-void Scope::update_last_exec_res(ManagedObject *value) {
-    change(Scope::lst_exec_res, ScopeEntry{ value, OBJECT });
-}
-
-
-ScopeEntry Scope::name_lookup(const std::string &name) {
+ScopeEntry Scope::name_lookup(Symbol name) {
     Scope *checkee = this;
     do {
         std::optional<ScopeEntry> curr_scope_lookup_res = checkee->get(name);
@@ -61,13 +106,28 @@ ScopeEntry Scope::name_lookup(const std::string &name) {
             return curr_scope_lookup_res.value();
         }
         if (checkee->parent_ == nullptr) {
-            throw std::runtime_error("Scope: cannot find name [" + name + "] in program scope");
+            throw std::runtime_error("Scope: cannot find name [" + name.str() + "] in program scope");
         }
         checkee = checkee->parent_;
     } while (true);
 }
 
 
+void Scope::bind_slots(const SlotLayout *layout) {
+    layout_ = layout;
+    slots_.assign(layout->names_.size(), Value{});
+}
+
+
+Value *Scope::slot_of(Symbol name) {
+    if (layout_ == nullptr) {
+        return nullptr;
+    }
+    std::optional<uint32_t> idx = layout_->find(name);
+    return idx.has_value() ? &slots_[idx.value()] : nullptr;
+}
+
+
 std::string Scope::scope_entry_function_name(const std::string &name) { return "__yapvm_inner_function_" + name; }
 
 
@@ -81,21 +141,27 @@ std::string Scope::scope_entry_thread_name(size_t id) {
 }
 
 
-ManagedObject *Scope::get_object(const std::string &name) {
+ManagedObject *Scope::get_object(Symbol name) {
+    if (Value *slot = slot_of(name); slot != nullptr) {
+        return slot->object();
+    }
     std::optional<std::reference_wrapper<ScopeEntry>> opt_from_kv = scope_[name];
     if (opt_from_kv == std::nullopt) return nullptr; 
     ScopeEntry se_ref = opt_from_kv.value().get();
-    return static_cast<ManagedObject *>(se_ref.value_);
+    return se_ref.object_.object();
 }
 
-FunctionDef *Scope::get_function(const std::string &signature) {
+FunctionDef *Scope::get_function(Symbol signature) {
     std::optional<std::reference_wrapper<ScopeEntry>> opt_from_kv = scope_[signature];
     if (opt_from_kv == std::nullopt) return nullptr; 
     ScopeEntry se_ref = opt_from_kv.value().get();
     return static_cast<FunctionDef *>(se_ref.value_);   
 }
 
-std::optional<ScopeEntry> Scope::get(const std::string &name) {
+std::optional<ScopeEntry> Scope::get(Symbol name) {
+    if (Value *slot = slot_of(name); slot != nullptr && !is_unbound(*slot)) {
+        return ScopeEntry{ nullptr, OBJECT, *slot };
+    }
     std::optional<std::reference_wrapper<ScopeEntry>> opt_from_kv = scope_[name];
     if (opt_from_kv == std::nullopt) return std::nullopt;
     ScopeEntry se_ref = opt_from_kv.value().get();
@@ -113,13 +179,17 @@ std::vector<Scope *> Scope::get_all_children() const {
 std::vector<ManagedObject *> yapvm::interpreter::Scope::get_all_objects() const {
     std::vector<ScopeEntry *> values = scope_.get_live_entries_values();
     std::vector<ManagedObject *> res;
+    for (const Value &v : slots_) {
+        if (v.object() != nullptr) {
+            res.push_back(v.object());
+        }
+    }
     for (auto se: values) {
-        if (se->value_ == nullptr)
-            continue;
-
         if (se->type_ == OBJECT) {
-            res.push_back(static_cast<ManagedObject *>(se->value_));
-        } else if (se->type_ == SCOPE) {
+            if (se->object_.object() != nullptr) {
+                res.push_back(se->object_.object());
+            }
+        } else if (se->type_ == SCOPE && se->value_ != nullptr) {
             auto scoped_objs = (static_cast<Scope *>(se->value_))->get_all_objects();
             res.insert(res.end(), scoped_objs.begin(), scoped_objs.end());
         }
@@ -127,11 +197,42 @@ std::vector<ManagedObject *> yapvm::interpreter::Scope::get_all_objects() const
     return res;
 }
 
+void Scope::visit_values(const std::function<void(Value &)> &visit) {
+    for (Value &v : slots_) {
+        if (!is_unbound(v)) {
+            visit(v);
+        }
+    }
+    scope_.for_each_live_value([&](ScopeEntry &se) {
+        if (se.type_ == OBJECT) {
+            visit(se.object_);
+        } else if (se.type_ == SCOPE && se.value_ != nullptr) {
+            Scope *child = static_cast<Scope *>(se.value_);
+            if (!child->thread_root_) {
+                child->visit_values(visit);
+            }
+        }
+    });
+}
+
+void Scope::set_thread_root(bool thread_root) {
+    thread_root_ = thread_root;
+}
+
+bool Scope::is_thread_root() const {
+    return thread_root_;
+}
+
 std::vector<std::pair<std::string, ScopeEntry>> Scope::get_all() const {
-    std::vector<std::pair<std::string *, ScopeEntry *>> all = scope_.get_live_entries();
+    std::vector<std::pair<Symbol *, ScopeEntry *>> all = scope_.get_live_entries();
     std::vector<std::pair<std::string, ScopeEntry>> ret;
-    for (std::pair<std::string *, ScopeEntry *> &e : all) {
-        ret.emplace_back(*e.first, *e.second);
+    for (std::pair<Symbol *, ScopeEntry *> &e : all) {
+        ret.emplace_back(e.first->str(), *e.second);
+    }
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (!is_unbound(slots_[i])) {
+            ret.emplace_back(layout_->names_[i].str(), ScopeEntry{ nullptr, OBJECT, slots_[i] });
+        }
     }
     return ret;
 }
@@ -0,0 +1,69 @@
+#include "symbol.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+
+using namespace yapvm;
+
+
+namespace {
+
+// names are interned while parsing and when strings reach string keyed api, so lookups take shared lock
+class SymbolTable {
+    std::shared_mutex monitor_;
+    std::deque<Symbol::Record> records_; // deque keeps records stable
+    std::unordered_map<std::string_view, const Symbol::Record *> index_; // views of record names
+
+public:
+    SymbolTable() { intern(""); }
+
+    const Symbol::Record *empty() const { return &records_.front(); }
+
+    const Symbol::Record *intern(std::string_view name) {
+        {
+            std::shared_lock lock{ monitor_ };
+            if (auto it = index_.find(name); it != index_.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock lock{ monitor_ };
+        if (auto it = index_.find(name); it != index_.end()) {
+            return it->second;
+        }
+        const Symbol::Record &record = records_.emplace_back(std::string{ name }, std::hash<std::string_view>{}(name));
+        index_.emplace(record.name_, &record);
+        return &record;
+    }
+
+    size_t size() {
+        std::shared_lock lock{ monitor_ };
+        return records_.size();
+    }
+};
+
+
+SymbolTable &symbol_table() {
+    static SymbolTable table;
+    return table;
+}
+
+}
+
+
+yapvm::Symbol::Symbol() : record_{ symbol_table().empty() } {}
+
+
+yapvm::Symbol::Symbol(std::string_view name) : record_{ symbol_table().intern(name) } {}
+
+
+std::ostream &yapvm::operator<<(std::ostream &out, const Symbol &symbol) {
+    return out << symbol.str();
+}
+
+
+size_t yapvm::interned_symbols_count() {
+    return symbol_table().size();
+}
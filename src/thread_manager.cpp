@@ -1,4 +1,6 @@
 #include "thread_manager.h"
+#include <algorithm>
+#include <chrono>
 #include "interpreter.h"
 
 //TODO park_all taking monitor and unregister cannot happen
@@ -38,14 +40,26 @@ std::optional<std::vector<yapvm::interpreter::Interpreter *>> yapvm::interpreter
 }
 
 
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+
 bool yapvm::interpreter::ThreadManager::park_all() {
     if (std::unique_lock lock = std::unique_lock{ monitor_, std::try_to_lock}) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_lock safepoint_lock{ safepoint_monitor_ };
+        epoch_++;
         for (Interpreter *interpreter : interpreters_) {
             interpreter->park();
         }
-        for (Interpreter *interpreter : interpreters_) {
-            while (!interpreter->is_parked());
-        }
+        parked_cv_.wait(safepoint_lock, [this] { return parked_ + in_safe_region_ == interpreters_.size(); });
+
+        uint64_t ttsp = elapsed_ns(start);
+        stats_.stops++;
+        stats_.ttsp_last_ns = ttsp;
+        stats_.ttsp_max_ns = std::max(stats_.ttsp_max_ns, ttsp);
+        stats_.ttsp_total_ns += ttsp;
         return true;
     }
     return false;
@@ -67,16 +81,72 @@ std::optional<bool> yapvm::interpreter::ThreadManager::is_all_parked() {
 
 bool yapvm::interpreter::ThreadManager::run_all() {
     if (std::unique_lock lock = std::unique_lock{ monitor_, std::try_to_lock}) {
-        for (Interpreter *i: interpreters_) {
-            i->run();
-            while (i->is_parked());
-        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_lock safepoint_lock{ safepoint_monitor_ };
+        epoch_++;
+        resume_cv_.notify_all();
+        // next park_all should not count interpreters which are still asleep from this stop
+        parked_cv_.wait(safepoint_lock, [this] { return parked_ == 0; });
+
+        uint64_t resume = elapsed_ns(start);
+        stats_.resume_max_ns = std::max(stats_.resume_max_ns, resume);
+        stats_.resume_total_ns += resume;
         return true;
     }
     return false;
 }
 
 
+void yapvm::interpreter::ThreadManager::block_at_safepoint() {
+    std::unique_lock safepoint_lock{ safepoint_monitor_ };
+    uint64_t epoch = epoch_;
+    if (epoch % 2 == 0) {
+        return; // park request left from stop which was passed in safe region
+    }
+    parked_++;
+    parked_cv_.notify_one();
+    resume_cv_.wait(safepoint_lock, [this, epoch] { return epoch_ != epoch; });
+    parked_--;
+    if (parked_ == 0) {
+        parked_cv_.notify_one();
+    }
+}
+
+
+void yapvm::interpreter::ThreadManager::enter_safe_region() {
+    std::unique_lock safepoint_lock{ safepoint_monitor_ };
+    in_safe_region_++;
+    parked_cv_.notify_one();
+}
+
+
+void yapvm::interpreter::ThreadManager::leave_safe_region() {
+    std::unique_lock safepoint_lock{ safepoint_monitor_ };
+    resume_cv_.wait(safepoint_lock, [this] { return epoch_ % 2 == 0; });
+    in_safe_region_--;
+}
+
+
+yapvm::interpreter::SafeRegion::SafeRegion(ThreadManager *tm) : tm_(tm) {
+    if (tm_ != nullptr) {
+        tm_->enter_safe_region();
+    }
+}
+
+
+yapvm::interpreter::SafeRegion::~SafeRegion() {
+    if (tm_ != nullptr) {
+        tm_->leave_safe_region();
+    }
+}
+
+
+yapvm::interpreter::SafepointStats yapvm::interpreter::ThreadManager::safepoint_stats() {
+    std::unique_lock safepoint_lock{ safepoint_monitor_ };
+    return stats_;
+}
+
+
 bool yapvm::interpreter::ThreadManager::finish_waiting() {
     if (std::unique_lock lock = std::unique_lock{ monitor_, std::try_to_lock}) {
         while (!join_queue_.empty()) {
@@ -1,87 +1,174 @@
 #include "y_objects.h"
 
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include "allocator.h"
 #include "parser.h"
 #include "utils.h"
 
 
-yapvm::yobjects::YObject::YObject(std::string type_name, void *value, KVStorage<std::string, ManagedObject *> *fields,
-                                  KVStorage<std::string, ast::FunctionDef *> *methods)
-                                      : typename_{std::move( type_name)}, ___yapvm_objval_{ value }, fields_{ fields }, methods_{ methods } {
+namespace {
 
+class TypenameRegistry {
+    std::mutex monitor_;
+    std::deque<std::string> names_; // deque keeps references to names stable
+    std::unordered_map<std::string, uint32_t> ids_;
+
+public:
+    TypenameRegistry() {
+        for (const char *name : { "None", "bool", "int", "float", "string", "list", "dict" }) {
+            ids_.emplace(name, static_cast<uint32_t>(names_.size()));
+            names_.emplace_back(name);
+        }
+    }
+
+    uint32_t id(const std::string &type_name) {
+        std::lock_guard lock{ monitor_ };
+        if (auto it = ids_.find(type_name); it != ids_.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names_.size());
+        ids_.emplace(type_name, id);
+        names_.push_back(type_name);
+        return id;
+    }
+
+    const std::string &name(uint32_t id) {
+        std::lock_guard lock{ monitor_ };
+        return names_.at(id);
+    }
+};
+
+
+TypenameRegistry &typename_registry() {
+    static TypenameRegistry registry;
+    return registry;
 }
 
+}
 
-yapvm::yobjects::YObject::YObject(std::string type_name) : typename_{std::move(type_name)}, ___yapvm_objval_{ nullptr }, fields_{ nullptr }, methods_{ nullptr } {}
 
+uint32_t yapvm::yobjects::typename_id(const std::string &type_name) {
+    return typename_registry().id(type_name);
+}
 
-yapvm::yobjects::YObject::YObject(std::string type_name, void *value) : typename_{ std::move(type_name) }, ___yapvm_objval_{ value }, fields_{ nullptr }, methods_{ nullptr } {}
 
+const std::string &yapvm::yobjects::typename_by_id(uint32_t id) {
+    return typename_registry().name(id);
+}
 
-yapvm::yobjects::YObject::~YObject() {
-    delete fields_;
-    delete methods_;
-    if (___yapvm_objval_ == nullptr) {
-        return;
-    }
-    if (typename_ == "bool") {
-        delete static_cast<bool *>(___yapvm_objval_);
-        return;
-    }
-    if (typename_ == "int") {
-        delete static_cast<int *>(___yapvm_objval_);
-        return;
-    }
-    if (typename_ == "float") {
-        delete static_cast<double *>(___yapvm_objval_);
-        return;
+
+struct __yobj_hash {
+    size_t operator()(yapvm::yobjects::ManagedObject *o) const {
+        return managed_yobject_hash(o);
     }
-    if (typename_ == "string") {
-        delete static_cast<std::string *>(___yapvm_objval_);
-        return;
+};
+
+
+using YDict = yapvm::yobjects::SlabKVStorage<yapvm::yobjects::ManagedObject *, yapvm::yobjects::ManagedObject *, __yobj_hash>;
+
+
+static yapvm::yobjects::YType type_by_typename_id(uint32_t id) {
+    using yapvm::yobjects::YType;
+    if (id < static_cast<uint32_t>(YType::User)) {
+        return static_cast<YType>(id);
     }
-    if (typename_ == "list") {
-        delete static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_);
-        return;
+    return YType::User;
+}
+
+
+yapvm::yobjects::YObject::YObject(YType type, uint32_t typename_id, YPayload payload, YFields *fields,
+                                  YMethods *methods)
+                                      : type_{ type }, typename_id_{ typename_id }, payload_{ payload }, fields_{ fields }, methods_{ methods } {
+
+}
+
+
+yapvm::yobjects::YObject::YObject(std::string type_name)
+    : typename_id_{ typename_id(type_name) }, payload_{ .ptr_ = nullptr }, fields_{ nullptr }, methods_{ nullptr } {
+    type_ = type_by_typename_id(typename_id_);
+}
+
+
+yapvm::yobjects::YObject::YObject(YType type, void *value)
+    : type_{ type }, typename_id_{ static_cast<uint32_t>(type) }, payload_{ .ptr_ = value }, fields_{ nullptr }, methods_{ nullptr } {
+    assert(type != YType::User && type != YType::Bool && type != YType::Int && type != YType::Float);
+}
+
+
+yapvm::yobjects::YObject::YObject(ssize_t value)
+    : type_{ YType::Int }, typename_id_{ static_cast<uint32_t>(YType::Int) }, payload_{ .int_ = value }, fields_{ nullptr }, methods_{ nullptr } {}
+
+
+yapvm::yobjects::YObject::YObject(double value)
+    : type_{ YType::Float }, typename_id_{ static_cast<uint32_t>(YType::Float) }, payload_{ .float_ = value }, fields_{ nullptr }, methods_{ nullptr } {}
+
+
+yapvm::yobjects::YObject::YObject(bool value)
+    : type_{ YType::Bool }, typename_id_{ static_cast<uint32_t>(YType::Bool) }, payload_{ .bool_ = value }, fields_{ nullptr }, methods_{ nullptr } {}
+
+
+yapvm::yobjects::YObject::YObject(YObject &&other) noexcept
+    : type_{ other.type_ }, typename_id_{ other.typename_id_ }, payload_{ other.payload_ }, fields_{ other.fields_ }, methods_{ other.methods_ } {
+    other.payload_.ptr_ = nullptr;
+    other.fields_ = nullptr;
+    other.methods_ = nullptr;
+}
+
+
+yapvm::yobjects::YObject &yapvm::yobjects::YObject::operator=(YObject &&other) noexcept {
+    if (&other != this) {
+        this->~YObject();
+        new (this) YObject{ std::move(other) };
     }
-    if (typename_ == "dict") {
-        delete static_cast<KVStorage<ManagedObject *, ManagedObject *> *>(___yapvm_objval_);
-        return;
+    return *this;
+}
+
+
+yapvm::yobjects::YObject::~YObject() {
+    memory::slab_delete(fields_);
+    memory::slab_delete(methods_);
+    switch (type_) {
+        case YType::String:
+            memory::slab_delete(static_cast<YString *>(payload_.ptr_));
+            return;
+        case YType::List:
+            memory::slab_delete(static_cast<YList *>(payload_.ptr_));
+            return;
+        case YType::Dict:
+            memory::slab_delete(static_cast<YDict *>(payload_.ptr_));
+            return;
+        default:
+            return; // primitives are inline
     }
 }
 
 
 yapvm::yobjects::YObject yapvm::yobjects::YObject::steal_personality() noexcept {
-    std::string tn = std::move(typename_);
-    KVStorage<std::string, ManagedObject *> *fields = fields_;
-    KVStorage<std::string, ast::FunctionDef *> *methods = methods_;
-    void *objval = ___yapvm_objval_;
-    fields_ = nullptr;
-    methods_ = nullptr;
-    ___yapvm_objval_ = nullptr;
-
-    return {tn, objval, fields, methods};
+    return YObject{ std::move(*this) };
 }
 
 
-void yapvm::yobjects::YObject::add_field(std::string name, ManagedObject *field) {
+void yapvm::yobjects::YObject::add_field(Symbol name, ManagedObject *field) {
     if (fields_ == nullptr) {
-        fields_ = new KVStorage<std::string, ManagedObject *>;
+        fields_ = memory::slab_new<YFields>();
     }
-    fields_->add(std::move(name), field);
+    fields_->add(name, field);
 }
 
 
-void yapvm::yobjects::YObject::add_method(std::string name, ast::FunctionDef *method) {
+void yapvm::yobjects::YObject::add_method(Symbol name, ast::FunctionDef *method) {
     if (methods_ == nullptr) {
-        methods_ = new KVStorage<std::string, ast::FunctionDef *>;
+        methods_ = memory::slab_new<YMethods>();
     }
-    methods_->add(std::move(name), method);
+    methods_->add(name, method);
 }
 
 
-yapvm::yobjects::ManagedObject *yapvm::yobjects::YObject::get_field(const std::string &name) {
+yapvm::yobjects::ManagedObject *yapvm::yobjects::YObject::get_field(Symbol name) {
     using kv_value_t = std::reference_wrapper<ManagedObject *>;
     if (fields_ == nullptr) {
         return nullptr;
@@ -93,7 +180,7 @@ yapvm::yobjects::ManagedObject *yapvm::yobjects::YObject::get_field(const std::s
 }
 
 
-yapvm::ast::FunctionDef *yapvm::yobjects::YObject::get_method(const std::string &name) {
+yapvm::ast::FunctionDef *yapvm::yobjects::YObject::get_method(Symbol name) {
     using kv_value_t = std::reference_wrapper<ast::FunctionDef *>;
     if (methods_ == nullptr) {
         return nullptr;
@@ -105,7 +192,7 @@ yapvm::ast::FunctionDef *yapvm::yobjects::YObject::get_method(const std::string
 }
 
 
-std::vector<std::string *> yapvm::yobjects::YObject::get_methods_names() const {
+std::vector<yapvm::Symbol *> yapvm::yobjects::YObject::get_methods_names() const {
     if (methods_ == nullptr) {
         return {};
     }
@@ -113,7 +200,7 @@ std::vector<std::string *> yapvm::yobjects::YObject::get_methods_names() const {
 }
 
 
-std::vector<std::string *> yapvm::yobjects::YObject::get_fields_names() const {
+std::vector<yapvm::Symbol *> yapvm::yobjects::YObject::get_fields_names() const {
     if (fields_ == nullptr) {
         return {};
     }
@@ -122,73 +209,84 @@ std::vector<std::string *> yapvm::yobjects::YObject::get_fields_names() const {
 
 std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::YObject::get_fields() {
     std::vector<ManagedObject *> res;
-    std::vector<std::string *> names = get_fields_names();
-    for (std::string *name : names) {
+    std::vector<Symbol *> names = get_fields_names();
+    for (Symbol *name : names) {
         res.push_back(get_field(*name));
     }
     return res;
 }
 
-void *yapvm::yobjects::YObject::get____yapvm_objval_() const { return ___yapvm_objval_; }
-
+std::vector<yapvm::yobjects::ManagedObject **> yapvm::yobjects::YObject::get_field_slots() {
+    if (fields_ == nullptr) {
+        return {};
+    }
+    return fields_->get_live_entries_values();
+}
 
-void yapvm::yobjects::YObject::set____yapvm_objval_(void *value) { ___yapvm_objval_ = value; }
+void *yapvm::yobjects::YObject::get____yapvm_objval_() const {
+    switch (type_) {
+        case YType::Bool:
+        case YType::Int:
+        case YType::Float:
+            return const_cast<YPayload *>(&payload_);
+        default:
+            return payload_.ptr_;
+    }
+}
 
 
-bool yapvm::yobjects::YObject::get_value_as_bool() const { return *static_cast<bool *>(___yapvm_objval_); }
+void yapvm::yobjects::YObject::set____yapvm_objval_(void *value) {
+    assert(type_ != YType::Bool && type_ != YType::Int && type_ != YType::Float);
+    payload_.ptr_ = value;
+}
 
 
 std::string yapvm::yobjects::YObject::get_value_as_string() const {
-    return *static_cast<std::string *>(___yapvm_objval_);
+    const YString &value = *static_cast<YString *>(payload_.ptr_);
+    return std::string{ value.data(), value.size() };
 }
 
-const std::vector<yapvm::yobjects::ManagedObject *> &yapvm::yobjects::YObject::get_value_as_list() const {
-    return *static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_);
+const yapvm::yobjects::YList &yapvm::yobjects::YObject::get_value_as_list() const {
+    return *static_cast<YList *>(payload_.ptr_);
 }
 
 
-double yapvm::yobjects::YObject::get_value_as_float() const { return *static_cast<double *>(___yapvm_objval_); }
-
-
-ssize_t yapvm::yobjects::YObject::get_value_as_int() const { return *static_cast<ssize_t *>(___yapvm_objval_); }
-
-
-void yapvm::yobjects::YObject::set_value_as_bool(bool value) const {
-    *static_cast<bool *>(___yapvm_objval_) = value;
+void yapvm::yobjects::YObject::set_value_as_bool(bool value) {
+    payload_.bool_ = value;
 }
 
 
 void yapvm::yobjects::YObject::set_value_as_string(std::string value) const {
-    *static_cast<std::string *>(___yapvm_objval_) = std::move(value);
+    static_cast<YString *>(payload_.ptr_)->assign(value.data(), value.size());
 }
 
-void yapvm::yobjects::YObject::set_value_as_float(double value) const {
-    *static_cast<double *>(___yapvm_objval_) = value;
+void yapvm::yobjects::YObject::set_value_as_float(double value) {
+    payload_.float_ = value;
 }
 
-void yapvm::yobjects::YObject::set_value_as_int(ssize_t value) const {
-    *static_cast<ssize_t *>(___yapvm_objval_) = value;
+void yapvm::yobjects::YObject::set_value_as_int(ssize_t value) {
+    payload_.int_ = value;
 }
 
-void yapvm::yobjects::YObject::set_value_as_list(std::vector<ManagedObject *> vec) const {
-    *static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_) = std::move(vec);
+void yapvm::yobjects::YObject::set_value_as_list(YList vec) const {
+    *static_cast<YList *>(payload_.ptr_) = std::move(vec);
 }
 
-yapvm::yobjects::ManagedObject *yapvm::yobjects::YObject::get_list_element(size_t idx) const {
-    return static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_)->at(idx);
+yapvm::yobjects::Value yapvm::yobjects::YObject::get_list_element(size_t idx) const {
+    return static_cast<YList *>(payload_.ptr_)->at(idx);
 }
 
-void yapvm::yobjects::YObject::set_list_element(size_t idx, ManagedObject *obj) const {
-    static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_)->at(idx) = obj;
+void yapvm::yobjects::YObject::set_list_element(size_t idx, Value obj) const {
+    static_cast<YList *>(payload_.ptr_)->at(idx) = obj;
 }
 
-void yapvm::yobjects::YObject::add_list_element(ManagedObject *obj) const {
-    std::vector<ManagedObject *> *list = static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_);
+void yapvm::yobjects::YObject::add_list_element(Value obj) const {
+    YList *list = static_cast<YList *>(payload_.ptr_);
     list->push_back(obj);
 }
 
 size_t yapvm::yobjects::YObject::get_len_as_list() const {
-    return static_cast<std::vector<ManagedObject *> *>(___yapvm_objval_)->size();
+    return static_cast<YList *>(payload_.ptr_)->size();
 }
 
 
@@ -198,61 +296,67 @@ yapvm::yobjects::YObject *yapvm::yobjects::constr_yobject(std::string type_name)
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_yint(ssize_t value) {
-    return new YObject{"int", new ssize_t{ value }};
+    return new YObject{ value };
 }
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_yfloat(double value) {
-    return new YObject{ "float", new double{ value }};
+    return new YObject{ value };
 }
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_ystring(std::string value) {
-    return new YObject{ "string", new std::string{ std::move(value) }};
+    return new YObject{ YType::String, memory::slab_new<YString>(value.data(), value.size()) };
 }
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_ybool(bool value) {
-    return new YObject{ "bool", new bool{ value }};
+    return new YObject{ value };
 }
 
 
-yapvm::yobjects::YObject *yapvm::yobjects::constr_ynone() { return new YObject{"None"}; }
+yapvm::yobjects::YObject *yapvm::yobjects::constr_ynone() { return new YObject{ YType::None }; }
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_ylist() {
-    return new YObject{"list", new std::vector<ManagedObject *>{}};
+    return new YObject{ YType::List, memory::slab_new<YList>() };
 }
 
 
 yapvm::yobjects::YObject *yapvm::yobjects::constr_ylist(std::vector<ManagedObject *> *vec) {
-    return new YObject{"list", vec};
+    return new YObject{ YType::List, memory::slab_new<YList>(vec->begin(), vec->end()) };
+}
+
+
+yapvm::yobjects::YObject *yapvm::yobjects::constr_ylist(YList *vec) {
+    return new YObject{ YType::List, vec };
 }
 
 
 bool yapvm::yobjects::is_collection(yapvm::yobjects::YObject * yobj) {
-    if (yobj->get_typename() == "list") {
-        return true;
-    }
-    if (yobj->get_typename() == "dict") {
-        return true;
-    }
-    return false;
+    return yobj->get_type() == YType::List || yobj->get_type() == YType::Dict;
 } 
 
 
 std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::get_list_elements(YObject *yobj) {
     // TODO maybe add checks or hide this function
-    return *static_cast<std::vector<ManagedObject *> *>(yobj->get____yapvm_objval_());
+    std::vector<ManagedObject *> res;
+    for (const Value &v : *static_cast<YList *>(yobj->get____yapvm_objval_())) {
+        if (v.object() != nullptr) {
+            res.push_back(v.object());
+        }
+    }
+    return res;
 }
 
 std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::get_dict_elements(yapvm::yobjects::YObject *yobj) {
     // TODO maybe add checks or hide this function
-    KVStorage<ManagedObject *, ManagedObject *> *dict = static_cast<KVStorage<ManagedObject *, ManagedObject *> *>(yobj->get____yapvm_objval_());
+    YDict *dict = static_cast<YDict *>(yobj->get____yapvm_objval_());
     // TODO 
     std::vector<ManagedObject **> values = dict->get_live_entries_values();
     std::vector<ManagedObject **> keys = dict->get_live_entries_keys();
-    std::vector<ManagedObject *> res{keys.size() + values.size()};
+    std::vector<ManagedObject *> res;
+    res.reserve(keys.size() + values.size());
 
     for (ManagedObject **val : values) {
         res.push_back(*val);
@@ -267,50 +371,48 @@ std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::get_dict_elements
 
 std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::get_collection_elements(YObject *yobj) {
     // TODO maybe add checks
-    if (yobj->get_typename() == "list") {
+    if (yobj->get_type() == YType::List) {
         return get_list_elements(yobj);
     }
-    if (yobj->get_typename() == "dict") {
+    if (yobj->get_type() == YType::Dict) {
         return get_dict_elements(yobj);
     }
     return std::vector<ManagedObject *> { };
 }
 
-struct __yobj_hash {
-    size_t operator()(yapvm::yobjects::ManagedObject *o) const {
-        return managed_yobject_hash(o);
-    }
-};
-
-
 yapvm::yobjects::YObject *yapvm::yobjects::constr_ydict() {
-    return new YObject{
-        "dict",
-        new KVStorage<
-            ManagedObject *,
-            ManagedObject *,
-            70, 30,
-            __yobj_hash
-        >
-    };
+    return new YObject{ YType::Dict, memory::slab_new<YDict>() };
 }
 
 
-yapvm::yobjects::ManagedObject::ManagedObject(YObject *value) : value_{value->steal_personality()}, marked_{false} {
+yapvm::yobjects::ManagedObject::ManagedObject(YObject *value) : value_{value->steal_personality()} {
     delete value;
 }
 
 
-yapvm::yobjects::YObject *yapvm::yobjects::ManagedObject::value() { return &value_; }
+yapvm::yobjects::ManagedObject::ManagedObject(YObject &&value) : value_{ std::move(value) } {}
+
+
+void *yapvm::yobjects::ManagedObject::operator new(size_t size) {
+    return memory::current_allocator()->allocate(size);
+}
+
+
+void yapvm::yobjects::ManagedObject::operator delete(void *data) {
+    memory::release(data);
+}
 
 
-bool yapvm::yobjects::ManagedObject::is_marked() const { return marked_; }
+bool yapvm::yobjects::ManagedObject::is_marked() const { return memory::Chunk::of(this)->is_marked(this); }
 
 
-void yapvm::yobjects::ManagedObject::mark() { marked_ = true; }
+void yapvm::yobjects::ManagedObject::mark() { memory::Chunk::of(this)->set_marked(this, true); }
 
 
-void yapvm::yobjects::ManagedObject::unmark() { marked_ = false; }
+void yapvm::yobjects::ManagedObject::unmark() { memory::Chunk::of(this)->set_marked(this, false); }
+
+
+bool yapvm::yobjects::ManagedObject::try_mark() { return memory::Chunk::of(this)->try_mark(this); }
 
 
 void yapvm::yobjects::ManagedObject::set_value(YObject *value) {
@@ -319,28 +421,136 @@ void yapvm::yobjects::ManagedObject::set_value(YObject *value) {
 }
 
 
-size_t yapvm::yobjects::managed_yobject_hash(ManagedObject *o) {
-    YObject *value = o->value();
-    assert(value != nullptr);
+void yapvm::yobjects::ManagedObject::set_list_element(size_t idx, Value obj) {
+    if (marking_active.load(std::memory_order_relaxed)) {
+        lock();
+        satb_enqueue(value_.get_list_element(idx).object());
+        value_.set_list_element(idx, obj);
+        unlock();
+    } else {
+        value_.set_list_element(idx, obj);
+    }
+    write_barrier(obj.object());
+}
 
-    const std::string &typename_ = value->get_typename();
 
-    if (typename_ == "None") {
-        return 0;
+void yapvm::yobjects::ManagedObject::add_list_element(Value obj) {
+    if (marking_active.load(std::memory_order_relaxed)) {
+        lock(); // list may be reallocated under marker
+        value_.add_list_element(obj);
+        unlock();
+    } else {
+        value_.add_list_element(obj);
     }
-    if (typename_ == "bool") {
-        return std::hash<bool>{}(value->get_value_as_bool());
-    }
-    if (typename_ == "string") {
-        return std::hash<std::string>{}(value->get_value_as_string());
+    write_barrier(obj.object());
+}
+
+
+void yapvm::yobjects::ManagedObject::add_field(Symbol name, ManagedObject *field) {
+    if (marking_active.load(std::memory_order_relaxed)) {
+        lock();
+        satb_enqueue(value_.get_field(name));
+        value_.add_field(name, field);
+        unlock();
+    } else {
+        value_.add_field(name, field);
     }
-    if (typename_ == "float") {
-        return std::hash<double>{}(value->get_value_as_float());
+    write_barrier(field);
+}
+
+
+static std::mutex remembered_mutex;
+static std::vector<yapvm::yobjects::ManagedObject *> remembered;
+
+
+void yapvm::yobjects::remember(ManagedObject *old_object) {
+    std::lock_guard lock{ remembered_mutex };
+    remembered.push_back(old_object);
+}
+
+
+std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::take_remembered() {
+    std::lock_guard lock{ remembered_mutex };
+    std::vector<ManagedObject *> res;
+    res.swap(remembered);
+    return res;
+}
+
+
+static std::mutex satb_mutex;
+static std::vector<yapvm::yobjects::ManagedObject *> satb;
+
+
+void yapvm::yobjects::satb_enqueue(ManagedObject *overwritten) {
+    if (overwritten == nullptr) {
+        return;
     }
-    if (typename_ == "int") {
-        return std::hash<ssize_t>{}(value->get_value_as_int());
+    std::lock_guard lock{ satb_mutex };
+    satb.push_back(overwritten);
+}
+
+
+std::vector<yapvm::yobjects::ManagedObject *> yapvm::yobjects::take_satb() {
+    std::lock_guard lock{ satb_mutex };
+    std::vector<ManagedObject *> res;
+    res.swap(satb);
+    return res;
+}
+
+
+yapvm::yobjects::ManagedObject *yapvm::yobjects::managed_yint(ssize_t value) {
+    return new ManagedObject{ YObject{ value } };
+}
+
+
+yapvm::yobjects::ManagedObject *yapvm::yobjects::managed_yfloat(double value) {
+    return new ManagedObject{ YObject{ value } };
+}
+
+
+yapvm::yobjects::ManagedObject *yapvm::yobjects::managed_ybool(bool value) {
+    return new ManagedObject{ YObject{ value } };
+}
+
+
+size_t yapvm::yobjects::managed_yobject_hash(ManagedObject *o) {
+    YObject *value = o->value();
+    assert(value != nullptr);
+
+    switch (value->get_type()) {
+        case YType::None:
+            return 0;
+        case YType::Bool:
+            return std::hash<bool>{}(value->get_value_as_bool());
+        case YType::String:
+            return std::hash<std::string>{}(value->get_value_as_string());
+        case YType::Float:
+            return std::hash<double>{}(value->get_value_as_float());
+        case YType::Int:
+            return std::hash<ssize_t>{}(value->get_value_as_int());
+        default:
+            break;
     }
     //TODO tuples? when added
 
     return std::hash<size_t>{}(reinterpret_cast<size_t>(o));
 }
+
+
+bool yapvm::yobjects::Value::operator==(const Value &other) const {
+    if (is_object_ != other.is_object_) {
+        return false;
+    }
+    if (is_object_) {
+        return object_ == other.object_;
+    }
+    if (type_ != other.type_) {
+        return false;
+    }
+    switch (type_) {
+        case YType::Bool: return bool_ == other.bool_;
+        case YType::Int: return int_ == other.int_;
+        case YType::Float: return float_ == other.float_;
+        default: return true;
+    }
+}
@@ -0,0 +1,286 @@
+#include "allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "y_objects.h"
+
+using namespace yapvm;
+using namespace yapvm::memory;
+
+
+TEST(allocator_test, bump_allocation) {
+    Heap heap;
+    TLAB tlab{ &heap };
+
+    char *first = static_cast<char *>(tlab.allocate(24));
+    char *second = static_cast<char *>(tlab.allocate(24));
+    EXPECT_EQ(second - first, 32); // rounded up to ALLOCATION_ALIGN
+    EXPECT_EQ(Chunk::of(first), Chunk::of(second));
+    EXPECT_EQ(heap.committed(), CHUNK_SIZE);
+
+    tlab.deallocate(first);
+    tlab.deallocate(second);
+    EXPECT_EQ(heap.committed(), CHUNK_SIZE); // still owned by tlab
+    tlab.retire();
+    EXPECT_EQ(heap.committed(), 0);
+}
+
+
+TEST(allocator_test, chunk_released_after_last_object) {
+    Heap heap;
+    TLAB tlab{ &heap };
+
+    void *obj = tlab.allocate(64);
+    tlab.retire();
+    EXPECT_EQ(heap.committed(), CHUNK_SIZE);
+    release(obj);
+    EXPECT_EQ(heap.committed(), 0);
+}
+
+
+TEST(allocator_test, max_heap_size) {
+    Heap heap{ CHUNK_SIZE };
+    TLAB tlab{ &heap };
+
+    size_t fits = (CHUNK_SIZE - sizeof(Chunk) - ALLOCATION_ALIGN) / 64; // header with mark bitmap
+    for (size_t i = 0; i < fits; i++) {
+        tlab.allocate(64);
+    }
+    EXPECT_THROW({ for (size_t i = 0; i < 8; i++) tlab.allocate(64); }, std::runtime_error);
+}
+
+
+TEST(allocator_test, large_payloads_are_committed) {
+    Heap &heap = Heap::instance();
+    size_t before = heap.committed();
+
+    void *data = slab_allocate(100000);
+    EXPECT_EQ(heap.committed(), before + 100000);
+    slab_deallocate(data, 100000);
+    EXPECT_EQ(heap.committed(), before);
+
+    heap.set_max_size(before + 50000);
+    EXPECT_THROW(slab_allocate(100000), OutOfMemory);
+    EXPECT_EQ(heap.committed(), before);
+    heap.set_max_size(SIZE_MAX);
+}
+
+
+TEST(allocator_test, initial_size_is_reserved) {
+    Heap heap;
+    heap.reserve(4 * CHUNK_SIZE);
+    EXPECT_EQ(heap.reserved(), 4 * CHUNK_SIZE);
+    EXPECT_EQ(heap.committed(), 0);
+
+    Chunk *chunk = heap.acquire_chunk();
+    EXPECT_EQ(heap.reserved(), 3 * CHUNK_SIZE);
+    EXPECT_EQ(heap.committed(), CHUNK_SIZE);
+
+    heap.release_chunk(chunk);
+    EXPECT_EQ(heap.reserved(), 4 * CHUNK_SIZE); // kept for next acquire
+    EXPECT_EQ(heap.committed(), 0);
+}
+
+
+TEST(allocator_test, managed_objects_use_current_allocator) {
+    Heap heap;
+    TLAB tlab{ &heap };
+    set_current_allocator(&tlab);
+
+    yobjects::ManagedObject *obj = yobjects::managed_yint(1);
+    EXPECT_EQ(Chunk::of(obj)->heap_, &heap);
+    delete obj;
+
+    set_current_allocator(nullptr);
+    tlab.retire();
+    EXPECT_EQ(heap.committed(), 0);
+}
+
+
+TEST(allocator_test, allocation_volume_wakes_gc) {
+    Heap heap;
+    heap.set_gc_trigger(2 * CHUNK_SIZE);
+    EXPECT_FALSE(heap.wait_for_gc_request(std::chrono::milliseconds{ 1 }));
+
+    std::thread allocator{ [&heap]() {
+        TLAB tlab{ &heap };
+        tlab.allocate(64);
+        heap.note_allocation(CHUNK_SIZE); // e.g. slab page
+    } };
+    while (!heap.wait_for_gc_request(std::chrono::milliseconds{ 1000 }));
+    allocator.join();
+
+    EXPECT_EQ(heap.take_allocated(), 2 * CHUNK_SIZE);
+    EXPECT_FALSE(heap.wait_for_gc_request(std::chrono::milliseconds{ 1 }));
+}
+
+
+static int finalized = 0;
+
+
+TEST(allocator_test, cell_space_sweeps_unmarked_cells) {
+    Heap heap;
+    CellSpace space{ &heap, 40, [](void *) { finalized++; } };
+
+    std::vector<void *> cells;
+    for (size_t i = 0; i < 10; i++) {
+        cells.push_back(space.allocate(40));
+    }
+    EXPECT_EQ(cells[1], static_cast<char *>(cells[0]) + 48); // rounded up to ALLOCATION_ALIGN
+    EXPECT_EQ(space.live(), 10);
+
+    Chunk::of(cells[3])->set_marked(cells[3], true);
+    Chunk::of(cells[7])->set_marked(cells[7], true);
+    space.start_sweep();
+    EXPECT_EQ(finalized, 0); // lazy
+
+    // allocation sweeps chunk and reuses first dead cell, marks are cleared
+    EXPECT_EQ(space.allocate(40), cells[0]);
+    EXPECT_EQ(finalized, 8);
+    EXPECT_EQ(space.live(), 3);
+    EXPECT_FALSE(Chunk::of(cells[3])->is_marked(cells[3]));
+
+    // nothing is marked, chunk becomes empty and is given back
+    space.start_sweep();
+    EXPECT_EQ(space.finish_sweep(), 3);
+    EXPECT_EQ(space.chunks(), 0);
+    EXPECT_EQ(heap.committed(), 0);
+}
+
+
+TEST(allocator_test, cell_space_evacuates_sparse_chunks) {
+    Heap heap;
+    CellSpace space{ &heap, 240, [](void *) {} };
+
+    // three full chunks and empty fourth one, then all but two cells of first two chunks are freed
+    std::vector<void *> cells;
+    while (space.chunks() < 4) {
+        cells.push_back(space.allocate(240));
+    }
+    space.deallocate(cells.back());
+    cells.pop_back();
+    size_t per_chunk = cells.size() / 3;
+    for (size_t i = 0; i < 2 * per_chunk; i++) {
+        if (i % per_chunk >= 2) {
+            space.deallocate(cells[i]);
+        }
+    }
+    EXPECT_GT(space.fragmentation(), 0.5);
+
+    // sparsest chunks are chosen while the rest can take their objects: empty and first ones
+    std::vector<void *> evacuated = space.start_evacuation(0.5);
+    ASSERT_EQ(evacuated.size(), 2);
+    for (void *cell : evacuated) {
+        EXPECT_EQ(Chunk::of(cell), Chunk::of(cells[0]));
+        void *copy = space.allocate(240);
+        EXPECT_EQ(Chunk::of(copy), Chunk::of(cells[per_chunk]));
+        space.deallocate(cell);
+    }
+    EXPECT_EQ(space.finish_evacuation(), 2);
+    EXPECT_EQ(space.chunks(), 2);
+    EXPECT_EQ(heap.committed(), 2 * CHUNK_SIZE);
+}
+
+
+TEST(allocator_test, slab_reuses_freed_block) {
+    void *first = slab_allocate(40);
+    slab_deallocate(first, 40);
+    void *second = slab_allocate(40);
+    EXPECT_EQ(first, second);
+    slab_deallocate(second, 40);
+
+    yobjects::YString *str = slab_new<yobjects::YString>(100, 'x');
+    EXPECT_EQ(str->size(), 100);
+    slab_delete(str);
+}
+
+
+TEST(allocator_test, slab_blocks_freed_by_other_thread_return_to_owner) {
+    constexpr size_t block = SLAB_MAX_BLOCK;
+    constexpr size_t per_page = SLAB_PAGE_SIZE / block - 1; // first block is taken by page header
+    std::vector<void *> first;
+    std::vector<void *> second;
+    std::atomic_bool allocated = false;
+    std::atomic_bool freed = false;
+
+    std::thread owner{ [&] {
+        for (size_t i = 0; i < per_page; i++) {
+            first.push_back(slab_allocate(block));
+        }
+        allocated.store(true);
+        while (!freed.load()) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < per_page; i++) {
+            second.push_back(slab_allocate(block));
+        }
+    } };
+    while (!allocated.load()) {
+        std::this_thread::yield();
+    }
+    for (void *data : first) {
+        slab_deallocate(data, block);
+    }
+    freed.store(true);
+    owner.join();
+
+    std::sort(first.begin(), first.end());
+    std::sort(second.begin(), second.end());
+    EXPECT_EQ(first, second);
+}
+
+
+TEST(allocator_test, slab_page_uncommitted_when_empty) {
+    constexpr size_t block = SLAB_MAX_BLOCK;
+    constexpr size_t per_page = SLAB_PAGE_SIZE / block - 1;
+    auto page_of = [](void *data) { return reinterpret_cast<uintptr_t>(data) & ~(SLAB_PAGE_SIZE - 1); };
+    Heap &heap = Heap::instance();
+
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 3 * per_page; i++) {
+        blocks.push_back(slab_allocate(block));
+    }
+    // second page is filled only by this test, last one is current page of thread
+    uintptr_t page = page_of(blocks[per_page]);
+    std::vector<void *> first;
+    for (void *data : blocks) {
+        if (page_of(data) == page) {
+            first.push_back(data);
+        }
+    }
+    ASSERT_EQ(first.size(), per_page);
+    ASSERT_NE(page, page_of(blocks.back()));
+
+    size_t before = heap.committed();
+    for (void *data : first) {
+        slab_deallocate(data, block);
+    }
+    EXPECT_EQ(heap.committed(), before - SLAB_PAGE_SIZE);
+
+    std::erase_if(blocks, [&](void *data) { return page_of(data) == page; });
+    for (void *data : blocks) {
+        slab_deallocate(data, block);
+    }
+}
+
+
+TEST(allocator_test, finished_thread_releases_empty_slab_pages) {
+    Heap &heap = Heap::instance();
+    size_t before = heap.committed();
+    std::thread worker{ [] {
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < 1000; i++) {
+            blocks.push_back(slab_allocate(200));
+        }
+        for (void *data : blocks) {
+            slab_deallocate(data, 200);
+        }
+    } };
+    worker.join();
+    EXPECT_EQ(heap.committed(), before);
+}
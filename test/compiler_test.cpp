@@ -0,0 +1,132 @@
+#include "compiler.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "interpreter.h"
+#include "parser.h"
+#include "utils.h"
+
+using namespace yapvm;
+using namespace yapvm::ast;
+using namespace yapvm::bytecode;
+
+
+TEST(compiler_test, module_ends_with_return) {
+    scoped_ptr<Module> module = parser::generate_ast(trim(read_file_ast("test_resources/arithmetic.py")));
+    scoped_ptr<Program> program = compiler::compile(module.get());
+
+    const CodeObject *code = program->module();
+    ASSERT_FALSE(code->code_.empty());
+    EXPECT_EQ(code->code_.back().op_, OP_RETURN_NONE);
+    EXPECT_EQ(code->def_, nullptr);
+}
+
+
+TEST(compiler_test, function_bodies_compiled) {
+    scoped_ptr<Module> module = parser::generate_ast(trim(read_file_ast("test_resources/fib.py")));
+    scoped_ptr<Program> program = compiler::compile(module.get());
+
+    FunctionDef *fib = checked_cast<Stmt, FunctionDef>(module->body()[0].get(), std::terminate);
+    const CodeObject *code = program->function_code(fib);
+    EXPECT_EQ(code->name_, "fib");
+    EXPECT_EQ(code->code_.front().op_, OP_SAFEPOINT);
+
+    size_t calls = 0;
+    for (const Instruction &ins : code->code_) {
+        if (ins.op_ == OP_CALL) {
+            calls++;
+            EXPECT_EQ(code->call_sites_[ins.arg_].argc_, 1);
+        }
+    }
+    EXPECT_EQ(calls, 2);
+}
+
+
+TEST(compiler_test, while_loop_jumps_back_to_safepoint) {
+    scoped_ptr<Module> module = parser::generate_ast(trim(read_file_ast("test_resources/mtsum.py")));
+    scoped_ptr<Program> program = compiler::compile(module.get());
+
+    FunctionDef *sum = checked_cast<Stmt, FunctionDef>(module->body()[0].get(), std::terminate);
+    const CodeObject *code = program->function_code(sum);
+    bool found_back_edge = false;
+    for (size_t i = 0; i < code->code_.size(); i++) {
+        const Instruction &ins = code->code_[i];
+        if (ins.op_ == OP_JUMP && ins.arg_ < i) {
+            EXPECT_EQ(code->code_[ins.arg_].op_, OP_SAFEPOINT);
+            found_back_edge = true;
+        }
+    }
+    EXPECT_TRUE(found_back_edge);
+}
+
+
+TEST(compiler_test, assigned_names_resolved_to_slots) {
+    scoped_ptr<Module> module = parser::generate_ast(trim(read_file_ast("test_resources/mtsum.py")));
+    scoped_ptr<Program> program = compiler::compile(module.get());
+
+    // args take first slots, names stored in loop body are locals too
+    FunctionDef *sum = checked_cast<Stmt, FunctionDef>(module->body()[0].get(), std::terminate);
+    const CodeObject *code = program->function_code(sum);
+    EXPECT_EQ(code->locals_.names_, (std::vector<Symbol>{ "n", "i" }));
+    for (const Instruction &ins : code->code_) {
+        EXPECT_NE(ins.op_, OP_LOAD_NAME);
+    }
+
+    const CodeObject *module_code = program->module();
+    EXPECT_TRUE(module_code->locals_.find("threads").has_value());
+    EXPECT_TRUE(module_code->locals_.find("i").has_value());
+    EXPECT_FALSE(module_code->locals_.find("p").has_value()); // functions are still looked up by name
+}
+
+
+TEST(compiler_test, call_sites_have_inline_caches) {
+    scoped_ptr<Module> module = parser::generate_ast(trim(read_file_ast("test_resources/fib.py")));
+    scoped_ptr<Program> program = compiler::compile(module.get());
+    FunctionDef *fib = checked_cast<Stmt, FunctionDef>(module->body()[0].get(), std::terminate);
+    const CodeObject *code = program->function_code(fib);
+    ASSERT_FALSE(code->call_sites_.empty());
+    CallCache &cache = code->call_caches_[0];
+
+    uint64_t scopes[CallCache::WAYS + 1] = { 1, 2, 3, 4, 5 };
+    bool polymorphic = false;
+    EXPECT_EQ(cache.find(scopes[0], 1, polymorphic), nullptr);
+    cache.insert(scopes[0], fib, 1);
+    EXPECT_EQ(cache.find(scopes[0], 1, polymorphic), fib);
+    EXPECT_FALSE(polymorphic);
+    EXPECT_EQ(cache.find(scopes[0], 2, polymorphic), nullptr); // functions changed since
+
+    cache.insert(scopes[1], fib, 1);
+    EXPECT_EQ(cache.find(scopes[0], 1, polymorphic), fib);
+    EXPECT_TRUE(polymorphic);
+
+    // refreshed in place, then replaced when all ways are taken
+    cache.insert(scopes[0], fib, 2);
+    EXPECT_EQ(cache.find(scopes[0], 2, polymorphic), fib);
+    for (uint64_t scope : scopes) {
+        cache.insert(scope, fib, 2);
+    }
+    EXPECT_EQ(cache.find(scopes[CallCache::WAYS], 2, polymorphic), fib);
+}
+
+
+static std::string run_script(const std::string &path, interpreter::ExecMode mode) {
+    testing::internal::CaptureStdout();
+    interpreter::ThreadManager tm;
+    interpreter::Interpreter interpreter{ parser::generate_ast(trim(read_file_ast(path))), &tm, new interpreter::Scope{}, mode };
+    interpreter.launch();
+    while (!tm.get_all_interpreters().value().empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    interpreter.join();
+    return testing::internal::GetCapturedStdout();
+}
+
+
+TEST(compiler_test, negative_list_indices_load_and_store) {
+    // bytecode and ast interpreter share index normalisation
+    EXPECT_EQ(run_script("test_resources/list_negative_index.py", interpreter::BYTECODE), "10 30 2");
+    EXPECT_EQ(run_script("test_resources/list_negative_index.py", interpreter::TREE_WALKER), "10 30 2");
+}
@@ -0,0 +1,84 @@
+#include "frame.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "compiler.h"
+#include "parser.h"
+#include "utils.h"
+
+using namespace yapvm;
+using namespace yapvm::interpreter;
+
+
+TEST(frame_test, frames_reuse_memory_over_blocks) {
+    bytecode::CodeObject code{ "f", nullptr };
+    for (size_t i = 0; i < 1000; i++) {
+        code.locals_.add("v" + std::to_string(i));
+    }
+
+    FrameStack stack;
+    std::vector<Frame *> frames;
+    Frame *caller = nullptr;
+    for (size_t i = 0; i < 64; i++) { // about 8KB per frame, several blocks
+        Frame *frame = stack.push(&code, caller);
+        EXPECT_EQ(frame->caller_, caller);
+        EXPECT_TRUE(Scope::is_unbound(frame->slots()[999]));
+        frame->slots()[999] = Value::from_int(static_cast<ssize_t>(i));
+        frames.push_back(frame);
+        caller = frame;
+    }
+    for (size_t i = 0; i < frames.size(); i++) {
+        EXPECT_EQ(frames[i]->slots()[999].get_value_as_int(), i);
+    }
+
+    while (frames.size() > 1) {
+        stack.pop(frames.back());
+        frames.pop_back();
+    }
+    EXPECT_EQ(stack.push(&code, frames.back()), reinterpret_cast<Frame *>(
+        reinterpret_cast<Value *>(frames.back() + 1) + 1000));
+}
+
+
+TEST(frame_test, get_finds_slots_and_dynamic_entries) {
+    bytecode::CodeObject code{ "f", nullptr };
+    code.locals_.add("n");
+
+    FrameStack stack;
+    Frame *frame = stack.push(&code, nullptr);
+    EXPECT_FALSE(frame->get("n").has_value());
+    frame->slots()[0] = Value::from_int(7);
+    EXPECT_EQ(frame->get("n").value().object_.get_value_as_int(), 7);
+
+    EXPECT_FALSE(frame->get("g").has_value());
+    frame->dynamic_scope()->change("g", ScopeEntry{ nullptr, FUNCTION });
+    EXPECT_EQ(frame->get("g").value().type_, FUNCTION);
+    stack.pop(frame);
+}
+
+
+TEST(frame_test, frame_scopes_keep_call_caches_warm) {
+    scoped_ptr<ast::Module> module = parser::generate_ast(trim(read_file_ast("test_resources/fib.py")));
+    scoped_ptr<bytecode::Program> program = compiler::compile(module.get());
+    ast::FunctionDef *fib = checked_cast<ast::Stmt, ast::FunctionDef>(module->body()[0].get(), std::terminate);
+    const bytecode::CodeObject *code = program->function_code(fib);
+    bytecode::CallCache &cache = code->call_caches_[0];
+
+    Scope scope;
+    cache.insert(scope.id(), fib, Scope::functions_epoch());
+
+    // nested def in a call of other thread, then new thread scope
+    FrameStack stack;
+    Frame *frame = stack.push(code, nullptr);
+    frame->dynamic_scope()->change(Scope::scope_entry_function_name("inner"), ScopeEntry{ fib, FUNCTION });
+    stack.pop(frame);
+    Scope thread_scope{ &scope };
+    EXPECT_NE(thread_scope.id(), scope.id());
+
+    bool polymorphic = true;
+    EXPECT_EQ(cache.find(scope.id(), Scope::functions_epoch(), polymorphic), fib);
+    EXPECT_FALSE(polymorphic);
+}
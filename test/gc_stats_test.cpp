@@ -0,0 +1,60 @@
+#include "gc_stats.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace yapvm::ygc;
+
+
+static CycleStats pause(uint64_t ns) {
+    CycleStats stats;
+    stats.kind_ = "minor";
+    stats.pause_ns_ = ns;
+    stats.allocated_bytes_ = 100;
+    return stats;
+}
+
+
+TEST(gc_stats_test, pause_percentiles) {
+    GCStats stats;
+    EXPECT_EQ(stats.pause_percentile(0.5), 0);
+
+    for (uint64_t ns = 100; ns >= 1; ns--) {
+        stats.record(pause(ns));
+    }
+    EXPECT_EQ(stats.cycles().size(), 100);
+    EXPECT_EQ(stats.cycles().front().cycle_, 1);
+    EXPECT_EQ(stats.pause_percentile(0.5), 50);
+    EXPECT_EQ(stats.pause_percentile(0.99), 99);
+    EXPECT_EQ(stats.pause_percentile(1.0), 100);
+    EXPECT_NE(stats.summary().find("\"pause_p99_ns\":99,"), std::string::npos);
+    EXPECT_NE(stats.summary().find("\"allocated_bytes\":10000,"), std::string::npos);
+}
+
+
+TEST(gc_stats_test, cycles_are_written_as_json_lines) {
+    std::string path = "gc_stats_test.jsonl";
+    {
+        GCStats stats;
+        stats.open(path);
+        stats.record(pause(7));
+        stats.record(pause(9));
+        stats.finish();
+    }
+
+    std::ifstream in{ path };
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "{\"cycle\":1,\"kind\":\"minor\",\"ttsp_ns\":0,\"pause_ns\":7,\"mark_ns\":0,\"sweep_ns\":0,"
+                    "\"allocated_bytes\":100,\"freed_bytes\":0,\"committed_bytes\":0,\"promoted_objects\":0,"
+                    "\"live_objects\":0}");
+    std::getline(in, line);
+    EXPECT_EQ(line.rfind("{\"cycle\":2,", 0), 0);
+    std::getline(in, line);
+    EXPECT_EQ(line.rfind("{\"summary\":{\"cycles\":2,\"pause_p50_ns\":7,\"pause_p99_ns\":9,", 0), 0);
+    EXPECT_FALSE(std::getline(in, line));
+    std::remove(path.c_str());
+}
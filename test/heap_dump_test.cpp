@@ -0,0 +1,84 @@
+#include "heap_dump.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include "gc.h"
+#include "scope.h"
+#include "thread_manager.h"
+#include "y_objects.h"
+
+using namespace yapvm;
+using namespace yapvm::ygc;
+
+
+// root -> a, a -> b, a -> c, b -> d, c -> d, d -> e
+static HeapDump diamond() {
+    HeapDump dump;
+    dump.type_names_[0] = "node";
+    dump.roots_ = { 0 };
+    dump.objects_ = {
+        { 0, 10, { 1, 2 } },
+        { 0, 10, { 3 } },
+        { 0, 10, { 3 } },
+        { 0, 10, { 4 } },
+        { 0, 10, {} },
+    };
+    return dump;
+}
+
+
+TEST(heap_dump_test, retained_sizes_by_dominators) {
+    HeapDump dump = diamond();
+    EXPECT_EQ(dump.retained_sizes(), (std::vector<uint64_t>{ 50, 10, 10, 20, 10 }));
+
+    // c is kept by root too, so d is not retained by a anymore
+    dump.roots_.push_back(2);
+    EXPECT_EQ(dump.retained_sizes(), (std::vector<uint64_t>{ 20, 10, 10, 20, 10 }));
+}
+
+
+TEST(heap_dump_test, write_and_read) {
+    std::string path = "heap_dump_test.bin";
+    diamond().write(path);
+    HeapDump dump = HeapDump::read(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(dump.roots_, std::vector<uint64_t>{ 0 });
+    ASSERT_EQ(dump.objects_.size(), 5);
+    EXPECT_EQ(dump.objects_[0].edges_, (std::vector<uint64_t>{ 1, 2 }));
+    EXPECT_EQ(dump.objects_[4].size_, 10);
+    EXPECT_EQ(dump.type_names_.at(0), "node");
+    std::string summary = dump.summary(1);
+    EXPECT_NE(summary.find("5 objects, 50 bytes, 1 roots"), std::string::npos);
+    EXPECT_NE(summary.find("50          10         2  #0 node"), std::string::npos);
+}
+
+
+TEST(heap_dump_test, gc_dumps_live_graph) {
+    interpreter::Scope scope;
+    yobjects::ManagedObject *greeting = new yobjects::ManagedObject{ yobjects::constr_ystring("hello!") };
+    yobjects::ManagedObject *greeter = new yobjects::ManagedObject{ yobjects::constr_yobject("Greeter") };
+    greeter->value()->add_field("greeting", greeting);
+    yobjects::ManagedObject *list = new yobjects::ManagedObject{ yobjects::constr_ylist() };
+    list->value()->add_list_element(greeter);
+    list->value()->add_list_element(greeting);
+    scope.add_object("l", list);
+    new yobjects::ManagedObject{ yobjects::constr_yint(1) }; // unreachable
+
+    interpreter::ThreadManager tm;
+    YGC gc{ &scope, &tm };
+    std::string path = "heap_dump_test_gc.bin";
+    gc.dump_heap(path);
+    HeapDump dump = HeapDump::read(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(dump.objects_.size(), 3);
+    EXPECT_EQ(dump.roots_, std::vector<uint64_t>{ 0 });
+    EXPECT_EQ(dump.objects_[0].edges_, (std::vector<uint64_t>{ 1, 2 }));
+    EXPECT_EQ(dump.type_names_.at(dump.objects_[1].type_id_), "Greeter");
+    EXPECT_EQ(dump.objects_[1].edges_, std::vector<uint64_t>{ 2 });
+    EXPECT_EQ(dump.retained_sizes()[0], dump.objects_[0].size_ + dump.objects_[1].size_ + dump.objects_[2].size_);
+}
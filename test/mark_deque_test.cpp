@@ -0,0 +1,83 @@
+#include "mark_deque.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace yapvm;
+using namespace yapvm::ygc;
+using yapvm::yobjects::ManagedObject;
+
+
+// deque never dereferences objects, fake addresses are enough
+static ManagedObject *fake(size_t i) {
+    return reinterpret_cast<ManagedObject *>((i + 1) * 16);
+}
+
+
+TEST(mark_deque_test, owner_lifo_thief_fifo) {
+    MarkDeque deque{ 4 };
+    for (size_t i = 0; i < 10; i++) {
+        deque.push(fake(i)); // grows twice
+    }
+    EXPECT_EQ(deque.steal(), fake(0));
+    EXPECT_EQ(deque.pop(), fake(9));
+    EXPECT_EQ(deque.steal(), fake(1));
+    for (size_t i = 8; i >= 2; i--) {
+        EXPECT_EQ(deque.pop(), fake(i));
+    }
+    EXPECT_TRUE(deque.empty());
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+}
+
+
+TEST(mark_deque_test, concurrent_steal_takes_every_item_once) {
+    constexpr size_t items = 200000;
+    constexpr size_t thieves = 3;
+    MarkDeque deque{ 16 };
+    std::atomic_bool done{ false };
+    std::vector<std::vector<size_t>> taken{ thieves + 1 };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thieves; t++) {
+        threads.emplace_back([&, t]() {
+            while (true) {
+                bool finished = done.load();
+                ManagedObject *obj = deque.steal();
+                if (obj != nullptr) {
+                    taken[t].push_back(reinterpret_cast<size_t>(obj) / 16 - 1);
+                } else if (finished && deque.empty()) {
+                    return;
+                }
+            }
+        });
+    }
+    for (size_t i = 0; i < items; i++) {
+        deque.push(fake(i));
+        if (i % 3 == 0) {
+            if (ManagedObject *obj = deque.pop()) {
+                taken[thieves].push_back(reinterpret_cast<size_t>(obj) / 16 - 1);
+            }
+        }
+    }
+    while (ManagedObject *obj = deque.pop()) {
+        taken[thieves].push_back(reinterpret_cast<size_t>(obj) / 16 - 1);
+    }
+    done = true;
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    std::vector<int> seen(items, 0);
+    for (const std::vector<size_t> &v : taken) {
+        for (size_t i : v) {
+            seen[i]++;
+        }
+    }
+    for (size_t i = 0; i < items; i++) {
+        EXPECT_EQ(seen[i], 1) << "item " << i;
+    }
+}
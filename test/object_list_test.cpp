@@ -0,0 +1,71 @@
+#include "object_list.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace yapvm;
+using namespace yapvm::ygc;
+using yapvm::yobjects::ManagedObject;
+
+
+// list never dereferences objects, fake addresses are enough
+static ManagedObject *fake(size_t i) {
+    return reinterpret_cast<ManagedObject *>((i + 1) * 16);
+}
+
+
+static std::vector<ManagedObject *> contents(const ObjectList &list) {
+    std::vector<ManagedObject *> res;
+    list.for_each([&](ManagedObject *obj) { res.push_back(obj); });
+    return res;
+}
+
+
+TEST(object_list_test, push_over_segments) {
+    ObjectList list;
+    size_t n = ObjectList::SEGMENT_OBJECTS * 2 + 3;
+    for (size_t i = 0; i < n; i++) {
+        list.push(fake(i));
+    }
+    EXPECT_EQ(n, list.size());
+
+    std::vector<ManagedObject *> res = contents(list);
+    ASSERT_EQ(n, res.size());
+    std::sort(res.begin(), res.end());
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(fake(i), res[i]);
+    }
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(contents(list).empty());
+}
+
+
+TEST(object_list_test, splice_takes_segments) {
+    ObjectList nursery;
+    ObjectList log;
+    nursery.push(fake(0));
+    for (size_t i = 1; i <= ObjectList::SEGMENT_OBJECTS; i++) {
+        log.push(fake(i));
+    }
+
+    nursery.splice(std::move(log));
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(ObjectList::SEGMENT_OBJECTS + 1, nursery.size());
+
+    // both lists stay usable
+    log.push(fake(100000));
+    nursery.push(fake(100001));
+    nursery.splice(ObjectList{});
+    EXPECT_EQ(1, log.size());
+    EXPECT_EQ(ObjectList::SEGMENT_OBJECTS + 2, nursery.size());
+    EXPECT_EQ(ObjectList::SEGMENT_OBJECTS + 2, contents(nursery).size());
+
+    ObjectList empty;
+    empty.splice(std::move(nursery));
+    EXPECT_EQ(ObjectList::SEGMENT_OBJECTS + 2, empty.size());
+    EXPECT_TRUE(nursery.empty());
+}
@@ -92,3 +92,88 @@ TEST(scope_test, subscopes) {
     size_t all_scopes = dfs_scope(&main_scope);
     EXPECT_EQ(4, all_scopes);
 }
+
+TEST(scope_test, visit_values_skips_thread_roots) {
+    Scope main_scope;
+    Scope *call_scope = new Scope{ &main_scope };
+    Scope *thread_scope = new Scope{ &main_scope };
+
+    main_scope.add_object("x", Value::from_int(1));
+    call_scope->add_object("y", Value::from_int(2));
+    thread_scope->add_object("z", Value::from_int(3));
+    main_scope.add_child_scope("call", call_scope);
+    main_scope.add_child_scope("thread", thread_scope);
+
+    auto visited_sum = [](Scope &scope) {
+        ssize_t sum = 0;
+        scope.visit_values([&](Value &v) {
+            if (!v.is_object()) {
+                sum += v.get_value_as_int();
+            }
+        });
+        return sum;
+    };
+    EXPECT_EQ(6, visited_sum(main_scope));
+
+    // running thread visits its scope itself
+    thread_scope->set_thread_root(true);
+    EXPECT_EQ(3, visited_sum(main_scope));
+    EXPECT_EQ(3, visited_sum(*thread_scope));
+
+    delete call_scope;
+    delete thread_scope;
+}
+
+TEST(scope_test, slots_are_found_by_name) {
+    SlotLayout layout;
+    EXPECT_EQ(0, layout.add("a"));
+    EXPECT_EQ(1, layout.add("b"));
+    EXPECT_EQ(0, layout.add("a"));
+
+    Scope main_scope;
+    main_scope.add_object("b", Value::from_int(10));
+    Scope call_scope{ &main_scope };
+    call_scope.bind_slots(&layout);
+
+    // unbound slot is still a free name
+    EXPECT_EQ(10, call_scope.name_lookup("b").object_.get_value_as_int());
+    EXPECT_FALSE(call_scope.get("a").has_value());
+
+    call_scope.slot(1) = Value::from_int(20);
+    call_scope.change("a", ScopeEntry{ nullptr, OBJECT, Value::from_int(30) });
+    EXPECT_EQ(30, call_scope.slot(0).get_value_as_int());
+    EXPECT_EQ(20, call_scope.name_lookup("b").object_.get_value_as_int());
+    EXPECT_EQ(2, call_scope.get_all().size());
+
+    ssize_t sum = 0;
+    call_scope.visit_values([&](Value &v) {
+        if (!v.is_object()) {
+            sum += v.get_value_as_int();
+        }
+    });
+    EXPECT_EQ(50, sum);
+
+    call_scope.del("b");
+    EXPECT_TRUE(Scope::is_unbound(call_scope.slot(1)));
+    EXPECT_EQ(10, call_scope.name_lookup("b").object_.get_value_as_int());
+}
+
+
+TEST(scope_test, function_changes_bump_epoch) {
+    Scope scope;
+    FunctionDef *fdef = reinterpret_cast<FunctionDef *>(0x10); // never dereferenced
+
+    uint64_t epoch = Scope::functions_epoch();
+    scope.add_object("x", Value::from_int(1));
+    scope.change("x", ScopeEntry{ nullptr, OBJECT, Value::from_int(2) });
+    EXPECT_EQ(epoch, Scope::functions_epoch());
+
+    scope.add_function("f", fdef);
+    EXPECT_NE(epoch, Scope::functions_epoch());
+    epoch = Scope::functions_epoch();
+    scope.change("f", ScopeEntry{ fdef, FUNCTION });
+    EXPECT_NE(epoch, Scope::functions_epoch());
+    epoch = Scope::functions_epoch();
+    scope.del("f");
+    EXPECT_NE(epoch, Scope::functions_epoch());
+}
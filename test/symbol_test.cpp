@@ -0,0 +1,56 @@
+#include "symbol.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scope.h"
+
+using namespace yapvm;
+
+
+TEST(symbol_test, equal_names_share_record) {
+    Symbol a{ "symbol_test_name" };
+    Symbol b{ std::string{ "symbol_test_" } + "name" };
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(&a.str(), &b.str());
+    EXPECT_EQ(a.hash(), std::hash<std::string_view>{}("symbol_test_name"));
+    EXPECT_NE(a, Symbol{ "symbol_test_other" });
+    EXPECT_EQ(Symbol{}, Symbol{ "" });
+}
+
+
+TEST(symbol_test, interned_from_many_threads) {
+    constexpr size_t THREADS = 4;
+    constexpr size_t NAMES = 1000;
+    size_t before = interned_symbols_count();
+    std::vector<std::vector<Symbol>> symbols(THREADS);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++) {
+        threads.emplace_back([&symbols, t] {
+            for (size_t i = 0; i < NAMES; i++) {
+                symbols[t].emplace_back("symbol_test_" + std::to_string(i));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(interned_symbols_count(), before + NAMES);
+    for (size_t t = 1; t < THREADS; t++) {
+        EXPECT_EQ(symbols[t], symbols[0]);
+    }
+}
+
+
+TEST(symbol_test, scope_keys_are_symbols) {
+    interpreter::Scope scope;
+    Symbol x{ "x" };
+    scope.add_object(x, Value::from_int(1));
+    EXPECT_EQ(scope.get(std::string{ "x" }).value().object_.get_value_as_int(), 1);
+    EXPECT_EQ(scope.get(x).value().object_.get_value_as_int(), 1);
+    EXPECT_FALSE(scope.get("y").has_value());
+}
@@ -71,3 +71,56 @@ TEST(y_object_test, y_custom_test) {
     EXPECT_EQ(obj->get_field("value"), val);
     EXPECT_EQ(obj->get_method("__eq__"), eq);
 }
+
+
+TEST(y_object_test, type_tags) {
+    EXPECT_EQ(constr_ynone()->get_type(), YType::None);
+    EXPECT_EQ(constr_ybool(false)->get_type(), YType::Bool);
+    EXPECT_EQ(constr_yint(1)->get_type(), YType::Int);
+    EXPECT_EQ(constr_yfloat(1.0)->get_type(), YType::Float);
+    EXPECT_EQ(constr_ystring("s")->get_type(), YType::String);
+    EXPECT_EQ(constr_ylist()->get_type(), YType::List);
+    EXPECT_EQ(constr_ydict()->get_type(), YType::Dict);
+    EXPECT_EQ(constr_ystring("s")->get_typename(), "string");
+
+    YObject *first = constr_yobject("Point");
+    YObject *second = constr_yobject("Point");
+    YObject *other = constr_yobject("Line");
+    EXPECT_EQ(first->get_type(), YType::User);
+    EXPECT_EQ(first->get_typename_id(), second->get_typename_id());
+    EXPECT_NE(first->get_typename_id(), other->get_typename_id());
+    EXPECT_EQ(other->get_typename(), "Line");
+
+    // builtin name passed as user type resolves to builtin tag
+    EXPECT_EQ(constr_yobject("int")->get_type(), YType::Int);
+}
+
+
+TEST(y_object_test, immediate_values) {
+    Value i = Value::from_int(42);
+    Value f = Value::from_float(2.5);
+    Value b = Value::from_bool(true);
+    EXPECT_FALSE(i.is_object());
+    EXPECT_EQ(i.object(), nullptr);
+    EXPECT_EQ(i.get_type(), YType::Int);
+    EXPECT_EQ(i.get_value_as_int(), 42);
+    EXPECT_EQ(f.get_value_as_float(), 2.5);
+    EXPECT_TRUE(b.get_value_as_bool());
+    EXPECT_EQ(Value::none().get_type(), YType::None);
+    EXPECT_EQ(i, Value::from_int(42));
+    EXPECT_FALSE(i == Value::from_float(42.0));
+
+    // heap primitives are still readable through Value
+    ManagedObject *boxed = new ManagedObject{ constr_yint(7) };
+    Value ref = boxed;
+    EXPECT_TRUE(ref.is_object());
+    EXPECT_EQ(ref.get_type(), YType::Int);
+    EXPECT_EQ(ref.get_value_as_int(), 7);
+
+    YObject *list = constr_ylist();
+    list->add_list_element(i);
+    list->add_list_element(ref);
+    EXPECT_EQ(get_list_elements(list), std::vector<ManagedObject *>{ boxed });
+    delete list;
+    delete boxed;
+}
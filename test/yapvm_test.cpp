@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/wait.h>
+
+
+// vm binary is run as a whole, exit code is checked as shell sees it
+static int run_yapvm(const std::string &args) {
+    int status = std::system((std::string(YAPVM_BIN) + " " + args + " > /dev/null 2>&1").c_str());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+
+TEST(yapvm_test, small_max_heap_size_is_error) {
+    // string constants do not fit already while module is generated
+    EXPECT_EQ(run_yapvm("test_resources/max_hs.py -Xmx 10k"), 1);
+    EXPECT_EQ(run_yapvm("test_resources/max_hs.py -Xmx 10k -Xast"), 1);
+}
+
+
+TEST(yapvm_test, heap_dump_without_major_collection) {
+    // short script ends before old generation limit, dump is written at exit
+    std::string path = "yapvm_test_heap_dump.bin";
+    std::remove(path.c_str());
+    EXPECT_EQ(run_yapvm("test_resources/fib.py -Xheapdump " + path), 0);
+    EXPECT_TRUE(std::filesystem::exists(path));
+    std::remove(path.c_str());
+}
+
+
+TEST(yapvm_test, no_gc_cycles_without_work) {
+    // ints in list are immediate, after first minor cycle only list payload grows and nursery gets nothing
+    std::string path = "yapvm_test_gc_stats.jsonl";
+    EXPECT_EQ(run_yapvm("test_resources/list_growth.py -Xgcstats " + path), 0);
+    std::ifstream in{ path };
+    ASSERT_TRUE(in.is_open());
+    size_t cycles = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"cycle\":") != std::string::npos) {
+            cycles++;
+        }
+        EXPECT_EQ(line.find("\"kind\":\"\""), std::string::npos) << line;
+    }
+    in.close();
+    std::remove(path.c_str());
+    EXPECT_GT(cycles, 0);
+}
@@ -129,7 +129,7 @@ TEST(gc_test, cycle_dependency) {
     YObject *foo = constr_yobject("Foo");
     ManagedObject *foo_obj = new ManagedObject { foo };
 
-    foo->add_field("l", list_obj);
+    foo_obj->value()->add_field("l", list_obj); // foo itself is deleted by ManagedObject
 
     scope.add_object("foo", foo_obj);
     scope.add_object("l", list_obj);
@@ -186,6 +186,180 @@ TEST(gc_test, sweep) {
     EXPECT_EQ(42, gc.left()[0]->value()->get_value_as_int());
 }
 
+TEST(gc_test, minor_promotes_survivors) {
+    // l = ["a"], "b" is garbage
+    Scope scope;
+    ThreadManager tm;
+    YGC gc (&scope, &tm);
+
+    ManagedObject *str_obj = new ManagedObject { constr_ystring("a") };
+    ManagedObject *garbage = new ManagedObject { constr_ystring("b") };
+    auto elements = new std::vector<ManagedObject *> { str_obj };
+    ManagedObject *list_obj = new ManagedObject { constr_ylist(elements) };
+    scope.add_object("l", list_obj);
+
+    std::vector<ManagedObject *> young { str_obj, garbage, list_obj };
+    gc.fill_young(young);
+    gc.minor();
+
+    EXPECT_TRUE(gc.young().empty());
+    EXPECT_EQ(2, gc.old_objects());
+
+    // survivors are copied, scope and list see new locations
+    ManagedObject *moved_list = scope.get_object("l");
+    ASSERT_NE(nullptr, moved_list);
+    EXPECT_EQ(Generation::Old, moved_list->generation());
+    EXPECT_FALSE(moved_list->is_marked());
+    ASSERT_EQ(1, moved_list->value()->get_len_as_list());
+    ManagedObject *moved_str = moved_list->value()->get_list_element(0).object();
+    EXPECT_EQ(Generation::Old, moved_str->generation());
+    EXPECT_EQ("a", moved_str->value()->get_value_as_string());
+    delete elements;
+}
+
+TEST(gc_test, remembered_set) {
+    // l is old, l.append("young") makes the only reference to young string
+    Scope scope;
+    ThreadManager tm;
+    YGC gc (&scope, &tm);
+
+    ManagedObject *list_obj = new ManagedObject { constr_ylist() };
+    scope.add_object("l", list_obj);
+    std::vector<ManagedObject *> old { list_obj };
+    gc.fill_left(old);
+
+    ManagedObject *str_obj = new ManagedObject { constr_ystring("young") };
+    std::vector<ManagedObject *> young { str_obj };
+    gc.fill_young(young);
+    list_obj->add_list_element(str_obj);
+
+    gc.minor();
+    EXPECT_EQ(2, gc.old_objects());
+    ManagedObject *moved_str = list_obj->value()->get_list_element(0).object();
+    EXPECT_EQ("young", moved_str->value()->get_value_as_string());
+    EXPECT_TRUE(take_remembered().empty());
+
+    // old to old store is not remembered
+    list_obj->add_list_element(moved_str);
+    EXPECT_TRUE(take_remembered().empty());
+}
+
+TEST(gc_test, parallel_mark) {
+    // l = [[0, "0"], [1, "1"], ...], every other inner list is unreachable
+    Scope scope;
+    ThreadManager tm;
+    YGC gc (&scope, &tm);
+    gc.set_mark_threads(4);
+
+    ManagedObject *outer = new ManagedObject { constr_ylist() };
+    scope.add_object("l", outer);
+    std::vector<ManagedObject *> reachable { outer };
+    std::vector<ManagedObject *> unreachable;
+    for (size_t i = 0; i < 20000; i++) {
+        ManagedObject *str = new ManagedObject { constr_ystring(std::to_string(i)) };
+        ManagedObject *inner = new ManagedObject { constr_ylist() };
+        inner->add_list_element(Value::from_int(static_cast<ssize_t>(i)));
+        inner->add_list_element(str);
+        if (i % 2 == 0) {
+            outer->add_list_element(inner);
+            reachable.push_back(inner);
+            reachable.push_back(str);
+        } else {
+            unreachable.push_back(inner);
+            unreachable.push_back(str);
+        }
+    }
+    gc.fill_left(reachable);
+    gc.fill_left(unreachable);
+
+    gc.mark();
+    for (ManagedObject *obj : reachable) {
+        EXPECT_TRUE(obj->is_marked());
+    }
+    for (ManagedObject *obj : unreachable) {
+        EXPECT_FALSE(obj->is_marked());
+    }
+
+    gc.sweep();
+    EXPECT_EQ(reachable.size(), gc.left().size());
+}
+
+TEST(gc_test, concurrent_mark_keeps_snapshot) {
+    // l = ["a"], s = "b" is garbage, then l[0] = "c" while marking
+    Scope scope;
+    ThreadManager tm;
+    YGC gc (&scope, &tm);
+
+    ManagedObject *a_obj = new ManagedObject { constr_ystring("a") };
+    ManagedObject *garbage = new ManagedObject { constr_ystring("b") };
+    ManagedObject *list_obj = new ManagedObject { constr_ylist() };
+    list_obj->add_list_element(a_obj);
+    scope.add_object("l", list_obj);
+    std::vector<ManagedObject *> old { a_obj, garbage, list_obj };
+    gc.fill_left(old);
+
+    gc.initial_mark();
+    EXPECT_TRUE(marking_active);
+
+    // new object is young and overwritten reference is logged
+    ManagedObject *c_obj = new ManagedObject { constr_ystring("c") };
+    std::vector<ManagedObject *> young { c_obj };
+    gc.fill_young(young);
+    list_obj->set_list_element(0, c_obj);
+
+    gc.concurrent_mark();
+    gc.remark();
+    EXPECT_FALSE(marking_active);
+
+    // a was reachable in snapshot, it is freed by next collection
+    EXPECT_EQ(2, gc.left().size());
+    EXPECT_EQ(1, gc.young().size());
+    EXPECT_EQ("c", list_obj->value()->get_list_element(0).yobject()->get_value_as_string());
+
+    gc.mark();
+    gc.sweep();
+    EXPECT_EQ(1, gc.left().size());
+}
+
+TEST(gc_test, compact_moves_sparse_old_objects) {
+    // l = [str(0), ..., str(n - 1)] is promoted, then only every 16th string is kept
+    Scope scope;
+    ThreadManager tm;
+    YGC gc (&scope, &tm);
+    take_remembered(); // left by previous tests
+
+    ManagedObject *list_obj = new ManagedObject { constr_ylist() };
+    scope.add_object("l", list_obj);
+    std::vector<ManagedObject *> young { list_obj };
+    const size_t n = 40000;
+    for (size_t i = 0; i < n; i++) {
+        ManagedObject *str = new ManagedObject { constr_ystring(std::to_string(i)) };
+        list_obj->add_list_element(str);
+        young.push_back(str);
+    }
+    gc.fill_young(young);
+    gc.minor();
+    EXPECT_EQ(n + 1, gc.old_objects());
+
+    ManagedObject *moved_list = scope.get_object("l");
+    for (size_t i = 0; i < n; i++) {
+        if (i % 16 != 0) {
+            moved_list->set_list_element(i, Value::from_int(0));
+        }
+    }
+    gc.compact();
+    EXPECT_LT(gc.fragmentation(), 0.5);
+
+    ManagedObject *compacted_list = scope.get_object("l");
+    for (size_t i = 0; i < n; i += 16) {
+        EXPECT_EQ(std::to_string(i), compacted_list->value()->get_list_element(i).yobject()->get_value_as_string());
+    }
+
+    // marks are cleared by sweep
+    gc.mark();
+    gc.sweep();
+    EXPECT_EQ(n / 16 + 1, gc.old_objects());
+}
 
 
 int main() {
@@ -0,0 +1,8 @@
+l = list()
+i = 0
+
+while i < 300000:
+    l += i
+    i = i + 1
+
+print("Grown")
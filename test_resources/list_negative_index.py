@@ -0,0 +1,7 @@
+l = list()
+l.append(1)
+l.append(2)
+l.append(3)
+l[-1] = 30
+l[-3] = 10
+print(str(l[-3]) + " " + str(l[-1]) + " " + str(l[1]))